@@ -0,0 +1,108 @@
+#include "async_writer.h"
+
+#include <cassert>
+
+async_writer::async_writer(const size_t w, const size_t h, const size_t capacity, const full_policy policy, sink_func sink)
+    : mSink(std::move(sink)), mCapacity(capacity ? capacity : 1), mPolicy(policy)
+{
+    // acquire() returns with at most mCapacity - 1 frames queued, plus the one being written and the one it returns
+    const size_t nbuffers = mCapacity + 1;
+    mBuffers.resize(nbuffers);
+    for (size_t i = 0; i < nbuffers; i++)
+    {
+        mBuffers[i].resize(w, h);
+        mFree.push_back(i);
+    }
+    mThread = std::thread(&async_writer::writer_loop, this);
+}
+
+framebuffer &async_writer::acquire()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    // the frame drawn into the returned buffer must find room in the queue when it is submitted
+    auto room = [this]() { return mQueue.size() < mCapacity && !mFree.empty(); };
+    if (!room())
+    {
+        if (mPolicy == full_policy::drop_oldest)
+        {
+            while (mQueue.size() >= mCapacity)
+            {
+                mFree.push_back(mQueue.front().first);
+                mQueue.pop_front();
+                mStats.dropped++;
+            }
+            mStats.depth = mQueue.size();
+        }
+        if (!room())
+        {
+            mStats.blocked++;
+            mCv.wait(lock, room);
+        }
+    }
+    const size_t id = mFree.front();
+    mFree.pop_front();
+    return mBuffers[id];
+}
+
+bool async_writer::submit(framebuffer &frame)
+{
+    const size_t id = &frame - mBuffers.data();
+    assert(id < mBuffers.size());
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.emplace_back(id, mStats.submitted++);
+        mStats.depth = mQueue.size();
+        if (mStats.depth > mStats.max_depth) mStats.max_depth = mStats.depth;
+        failed = mFailed;
+    }
+    mCv.notify_all();
+    return !failed;
+}
+
+bool async_writer::finish()
+{
+    if (!mThread.joinable()) return !mFailed;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCv.notify_all();
+    mThread.join();
+    return !mFailed;
+}
+
+async_writer::stats async_writer::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+void async_writer::writer_loop()
+{
+    for (;;)
+    {
+        std::pair<size_t, size_t> item;
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCv.wait(lock, [this]() { return !mQueue.empty() || mStop; });
+            if (mQueue.empty()) return; // stopping, and everything was written
+            item = mQueue.front();
+            mQueue.pop_front();
+            mStats.depth = mQueue.size();
+            failed = mFailed;
+        }
+
+        // once the sink failed, frames are only recycled so the renderer never waits forever
+        const bool ok = failed || mSink(mBuffers[item.first], item.second);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFree.push_back(item.first);
+            if (!ok) mFailed = true;
+            else if (!failed) mStats.written++;
+        }
+        mCv.notify_all();
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "framebuffer.h"
+
+// Writes frames on a background thread so I/O latency stays off the render thread.
+// Frames live in a pool of buffers allocated once: the renderer acquire()s one, draws into it and submit()s it,
+// which returns at once. The writer hands queued frames to the sink in order and puts the buffers back in the pool.
+// At most capacity frames wait in the queue: acquire() with capacity frames queued either waits for the writer (block)
+// or takes back the oldest frame not written yet (drop_oldest). The pool holds capacity + 1 buffers, enough for the
+// capacity - 1 frames queued past that check, the one being written and the one the renderer draws.
+class async_writer
+{
+public:
+    enum class full_policy
+    {
+        block,
+        drop_oldest,
+    };
+
+    // called on the writer thread for every frame, index counts submitted frames from 0. Returns false on failure
+    typedef std::function<bool(const framebuffer &frame, const size_t index)> sink_func;
+
+    struct stats
+    {
+        size_t submitted = 0;
+        size_t written = 0;
+        size_t blocked = 0;   // acquire() calls that had to wait for the writer
+        size_t dropped = 0;   // frames taken back before they were written
+        size_t depth = 0;     // frames queued right now, not counting the one being written
+        size_t max_depth = 0; // deepest the queue has been
+    };
+
+    async_writer(const size_t w, const size_t h, const size_t capacity, const full_policy policy, sink_func sink);
+    ~async_writer() { finish(); }
+    async_writer(const async_writer &) = delete;
+    async_writer &operator=(const async_writer &) = delete;
+
+    // a w x h buffer from the pool, its content is whatever the last frame in it was
+    framebuffer &acquire();
+    // queues a buffer obtained from acquire(), returns false once the sink failed
+    bool submit(framebuffer &frame);
+    // writes everything still queued and stops the thread, returns false if the sink ever failed
+    bool finish();
+
+    stats get_stats() const;
+
+private:
+    void writer_loop();
+
+    std::vector<framebuffer> mBuffers;           // the pool
+    std::deque<size_t> mFree;                    // buffers nobody uses
+    std::deque<std::pair<size_t, size_t>> mQueue; // (buffer, frame index) waiting for the writer
+    sink_func mSink;
+    size_t mCapacity; // most frames waiting in mQueue
+    full_policy mPolicy;
+
+    std::thread mThread;
+    mutable std::mutex mMutex;
+    std::condition_variable mCv;
+    stats mStats;
+    bool mStop = false;
+    bool mFailed = false;
+};
+
+#endif // !ASYNC_WRITER_H
@@ -0,0 +1,578 @@
+#include "bench.h"
+#include "raycast.h"
+#include "camera.h"
+#include "coarse_grid.h"
+#include "distance_field.h"
+#include "entity_grid.h"
+#include "image.h"
+#include "render.h"
+#include "simd.h"
+#include "sprite.h"
+#include "thread_pool.h"
+#include "tiled_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // runs func until at least min_seconds went by, returns the average time of one call in seconds
+    template<typename F> double time_it(F func, const double min_seconds = 0.25)
+    {
+        using clock = std::chrono::steady_clock;
+        size_t iterations = 0;
+        const auto start = clock::now();
+        double elapsed = 0.0;
+        do
+        {
+            func();
+            iterations++;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while (elapsed < min_seconds);
+        return elapsed / iterations;
+    }
+
+    // a w x h maze of corridors one cell wide, the same one every time: walls on the border and between the rooms
+    // at odd coordinates, knocked down by a depth first walk
+    void make_maze(map_grid &maze, const size_t w, const size_t h, const size_t nkinds)
+    {
+        maze.assign(w, h);
+        for (size_t j = 0; j < h; j++)
+        {
+            for (size_t i = 0; i < w; i++)
+            {
+                if (i % 2 == 0 || j % 2 == 0 || i == w - 1 || j == h - 1) maze.set(i, j, uint8_t((i + j) % nkinds));
+            }
+        }
+        const size_t rooms_w = (w - 1) / 2, rooms_h = (h - 1) / 2;
+        std::vector<bool> seen(rooms_w * rooms_h, false);
+        std::vector<size_t> stack(1, 0);
+        seen[0] = true;
+        maze.set(1, 1, empty_cell);
+        std::mt19937 rng(1);
+        while (!stack.empty())
+        {
+            const size_t room = stack.back();
+            const size_t rx = room % rooms_w, ry = room / rooms_w;
+            size_t next[4], nnext = 0;
+            if (rx > 0 && !seen[room - 1]) next[nnext++] = room - 1;
+            if (rx + 1 < rooms_w && !seen[room + 1]) next[nnext++] = room + 1;
+            if (ry > 0 && !seen[room - rooms_w]) next[nnext++] = room - rooms_w;
+            if (ry + 1 < rooms_h && !seen[room + rooms_w]) next[nnext++] = room + rooms_w;
+            if (nnext == 0)
+            {
+                stack.pop_back();
+                continue;
+            }
+            const size_t to = next[rng() % nnext];
+            const size_t tx = to % rooms_w, ty = to / rooms_w;
+            maze.set(rx + tx + 1, ry + ty + 1, empty_cell); // the wall between the two rooms
+            maze.set(2 * tx + 1, 2 * ty + 1, empty_cell);
+            seen[to] = true;
+            stack.push_back(to);
+        }
+    }
+}
+
+void bench_raycast(const map_view &map,
+                   const float x, const float y, const float view_angle, const float fov,
+                   const size_t ncolumns, const float max_dist)
+{
+    std::vector<ray_hit> dda(ncolumns), march(ncolumns);
+
+    const camera cam = make_camera(x, y, view_angle, fov);
+    ray_table rays;
+    rays.update(cam, ncolumns);
+    std::vector<float> angles(ncolumns); // the marcher wants angles, give it the same rays
+    for (size_t i = 0; i < ncolumns; i++)
+    {
+        angles[i] = atan2f(rays.dir_y()[i], rays.dir_x()[i]);
+    }
+
+    const double dda_time = time_it([&]()
+    {
+        for (size_t i = 0; i < ncolumns; i++)
+        {
+            dda[i] = cast_ray(map, x, y, rays.dir_x()[i], rays.dir_y()[i], max_dist);
+        }
+    });
+    const double march_time = time_it([&]()
+    {
+        for (size_t i = 0; i < ncolumns; i++)
+        {
+            march[i] = march_ray(map, x, y, angles[i], max_dist);
+        }
+    });
+
+    // both should agree on the distance within the marcher step, the dda one is in units of |dir|.
+    // when they don't, the marcher stepped right over the corner of a wall
+    float max_err = 0.0f;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < ncolumns; i++)
+    {
+        if (dda[i].hit != march[i].hit) { mismatches++; continue; }
+        if (!dda[i].hit) continue;
+        const float dir_len = sqrtf(rays.dir_x()[i] * rays.dir_x()[i] + rays.dir_y()[i] * rays.dir_y()[i]);
+        const float err = fabsf(dda[i].dist * dir_len - march[i].dist);
+        if (err > 0.02f) mismatches++;
+        else max_err = std::max(max_err, err);
+    }
+
+    std::cout << "raycast " << map.w << "x" << map.h << ", " << ncolumns << " rays, max distance " << max_dist << "\n"
+              << "    march: " << march_time * 1e9 / ncolumns << " ns/ray\n"
+              << "    dda:   " << dda_time * 1e9 / ncolumns << " ns/ray (x" << march_time / dda_time << ")\n"
+              << "    max distance error " << max_err << ", " << mismatches << " rays where the marcher missed a corner" << std::endl;
+
+    // packets, at every level the host supports. They must give the same hits as cast_ray(). Distances are only
+    // close: cast_ray() jumps over long runs of cells with one multiply where packets add delta at every step
+    const simd_level best = detect_simd_level();
+    std::vector<ray_hit> packet(ncolumns);
+    std::vector<uint32_t> heights(ncolumns);
+    for (int level = int(simd_level::sse2); level <= int(best); level++)
+    {
+        set_simd_level(simd_level(level));
+        const double packet_time = time_it([&]()
+        {
+            cast_rays(map, x, y, rays.dir_x(), rays.dir_y(), ncolumns, max_dist, 512.0f, packet.data(), heights.data());
+        });
+        size_t differences = 0;
+        for (size_t i = 0; i < ncolumns; i++)
+        {
+            if (packet[i].hit != dda[i].hit || packet[i].cell != dda[i].cell || (dda[i].hit && fabsf(packet[i].dist - dda[i].dist) > 1e-5f * std::max(1.0f, dda[i].dist))) differences++;
+        }
+        std::cout << "    " << simd_level_name(simd_level(level)) << " packets: " << packet_time * 1e9 / ncolumns
+                  << " ns/ray (x" << dda_time / packet_time << " over dda), " << differences << " rays differ" << std::endl;
+    }
+    set_simd_level(best);
+}
+
+void bench_traversal(const char *name, const map_view &map, const float x, const float y, const size_t nrays, const float max_dist)
+{
+    std::vector<float> dir_x(nrays), dir_y(nrays);
+    for (size_t i = 0; i < nrays; i++)
+    {
+        const float angle = 6.2831853f * (i + 0.5f) / nrays;
+        dir_x[i] = cosf(angle);
+        dir_y[i] = sinf(angle);
+    }
+    coarse_grid coarse;
+    distance_field field;
+    const double coarse_build = time_it([&]() { coarse.build(map); }, 0.05);
+    const double field_build = time_it([&]() { field.build(map); }, 0.05);
+
+    std::vector<ray_hit> dda(nrays), hits(nrays);
+    std::vector<uint32_t> heights(nrays);
+    const double dda_time = time_it([&]()
+    {
+        for (size_t i = 0; i < nrays; i++) dda[i] = cast_ray(map, x, y, dir_x[i], dir_y[i], max_dist);
+    });
+
+    std::cout << "traversal on " << name << " " << map.w << "x" << map.h << ", " << nrays << " rays, max distance " << max_dist << "\n"
+              << "    built " << coarse.levels() << " coarse levels in " << coarse_build * 1e3 << " ms, the distance field in "
+              << field_build * 1e3 << " ms\n"
+              << "    dda, one ray at a time: " << dda_time * 1e9 / nrays << " ns/ray" << std::endl;
+    for (const traversal mode : {traversal::march, traversal::dda, traversal::coarse, traversal::distance_field})
+    {
+        const float *dx = dir_x.data(), *dy = dir_y.data();
+        const double t = time_it([&]()
+        {
+            switch (mode)
+            {
+                case traversal::march: march_rays(map, x, y, dx, dy, nrays, max_dist, 512.0f, hits.data(), heights.data()); break;
+                case traversal::dda: cast_rays(map, x, y, dx, dy, nrays, max_dist, 512.0f, hits.data(), heights.data()); break;
+                case traversal::coarse: cast_rays(map, coarse, x, y, dx, dy, nrays, max_dist, 512.0f, hits.data(), heights.data()); break;
+                case traversal::distance_field: cast_rays(map, field, x, y, dx, dy, nrays, max_dist, 512.0f, hits.data(), heights.data()); break;
+            }
+        });
+
+        // everything but the marcher must land on the same cells as the dda
+        size_t differences = 0;
+        for (size_t i = 0; i < nrays; i++)
+        {
+            if (hits[i].hit != dda[i].hit || (dda[i].hit && (hits[i].map_x != dda[i].map_x || hits[i].map_y != dda[i].map_y))) differences++;
+        }
+        std::cout << "    " << traversal_name(mode) << (mode == traversal::dda ? std::string(" (") + simd_level_name(get_simd_level()) + " packets)" : "")
+                  << ": " << t * 1e9 / nrays << " ns/ray (x" << dda_time / t << "), " << differences << " rays hit another cell" << std::endl;
+    }
+}
+
+void bench_map_layout(const size_t map_w, const size_t map_h, const size_t nkinds)
+{
+    // walls scattered at random, 1 cell in 200, rays go a hundred cells or so before hitting one
+    std::mt19937 rng(1);
+    map_grid grid(map_w, map_h);
+    for (size_t j = 0; j < map_h; j++)
+    {
+        for (size_t i = 0; i < map_w; i++)
+        {
+            if (i == 0 || j == 0 || i == map_w - 1 || j == map_h - 1 || rng() % 200 == 0) grid.set(i, j, uint8_t((i + j) % nkinds));
+        }
+    }
+    const map_view rows = grid.view();
+    tiled_map tiled;
+    const double build_time = time_it([&]() { tiled.build(rows); }, 0.05);
+    const tiled_view tiles = tiled.view();
+
+    // rays in every direction from starts spread over the whole map, so they don't share cache lines much, sorted
+    // by how they head: mostly along x, diagonal, mostly along y
+    const size_t nstarts = 64, ndirs = 256;
+    struct ray { float x, y, dir_x, dir_y; };
+    std::vector<ray> groups[3];
+    for (size_t s = 0; s < nstarts; s++)
+    {
+        const float x = 1.0f + float(rng() % (map_w - 2)) + 0.5f, y = 1.0f + float(rng() % (map_h - 2)) + 0.5f;
+        for (size_t i = 0; i < ndirs; i++)
+        {
+            const float angle = 6.2831853f * (i + 0.5f) / ndirs;
+            const float dx = cosf(angle), dy = sinf(angle);
+            groups[fabsf(dy) < 0.5f ? 0 : fabsf(dx) < 0.5f ? 2 : 1].push_back(ray{x, y, dx, dy});
+        }
+    }
+
+    std::cout << "map layout " << map_w << "x" << map_h << ", " << nstarts * ndirs << " rays from " << nstarts
+              << " places, tiles built in " << build_time * 1e3 << " ms" << std::endl;
+    const char *names[3] = {"mostly along x", "diagonal", "mostly along y"};
+    for (size_t g = 0; g < 3; g++)
+    {
+        const std::vector<ray> &rays = groups[g];
+        std::vector<ray_hit> row_hits(rays.size()), tile_hits(rays.size());
+        const double row_time = time_it([&]()
+        {
+            for (size_t i = 0; i < rays.size(); i++) row_hits[i] = cast_ray(rows, rays[i].x, rays[i].y, rays[i].dir_x, rays[i].dir_y, float(map_w));
+        });
+        const double tile_time = time_it([&]()
+        {
+            for (size_t i = 0; i < rays.size(); i++) tile_hits[i] = cast_ray(tiles, rays[i].x, rays[i].y, rays[i].dir_x, rays[i].dir_y, float(map_w));
+        });
+        size_t differences = 0;
+        for (size_t i = 0; i < rays.size(); i++)
+        {
+            if (row_hits[i].hit != tile_hits[i].hit || row_hits[i].map_x != tile_hits[i].map_x || row_hits[i].map_y != tile_hits[i].map_y ||
+                row_hits[i].cell != tile_hits[i].cell) differences++;
+        }
+        std::cout << "    " << names[g] << ": row-major " << row_time * 1e9 / rays.size() << " ns/ray, tiled "
+                  << tile_time * 1e9 / rays.size() << " ns/ray (x" << row_time / tile_time << "), " << differences
+                  << " rays differ" << std::endl;
+    }
+}
+
+void bench_render_walls(const scene &sc,
+                        const float x, const float y, const float view_angle, const float fov,
+                        const size_t img_w, const size_t img_h, const float max_dist, const size_t nthreads)
+{
+    framebuffer img(img_w, img_h);
+    const camera cam = make_camera(x, y, view_angle, fov);
+    ray_table rays;
+    rays.update(cam, img_w);
+    std::vector<ray_hit> hits;
+
+    thread_pool single(1);
+    thread_pool pool(nthreads);
+    const double single_time = time_it([&]()
+    {
+        render_walls(img.view(), column_layout::row_major, sc, cam, rays, max_dist, single, hits);
+    });
+    const double pool_time = time_it([&]()
+    {
+        render_walls(img.view(), column_layout::row_major, sc, cam, rays, max_dist, pool, hits);
+    });
+
+    std::cout << "render_walls " << img_w << "x" << img_h << " on a " << sc.map.w << "x" << sc.map.h << " map\n"
+              << "    1 thread:  " << single_time * 1e3 << " ms/frame\n"
+              << "    " << pool.size() << " threads: " << pool_time * 1e3 << " ms/frame (x" << single_time / pool_time << ")" << std::endl;
+}
+
+void bench_render_target(const scene &sc,
+                         const float x, const float y, const float view_angle, const float fov,
+                         const size_t img_w, const size_t img_h, const float max_dist, const size_t nthreads)
+{
+    framebuffer fb(img_w, img_h);
+    const camera cam = make_camera(x, y, view_angle, fov);
+    renderer rend(nthreads, column_layout::row_major);
+    rend.set_clear_mode(clear_mode::cached);
+    const double direct_time = time_it([&]() { rend.render_frame(fb, sc, cam, max_dist); });
+    rend.set_clear_mode(clear_mode::streaming);
+    const double streaming_time = time_it([&]() { rend.render_frame(fb, sc, cam, max_dist); });
+    rend.set_clear_mode(clear_mode::cached);
+    rend.set_layout(column_layout::column_major);
+    const double transposed_time = time_it([&]() { rend.render_frame(fb, sc, cam, max_dist); });
+
+    // the transpose alone, on the same buffer sizes
+    framebuffer columns(img_h, img_w / 2);
+    const double transpose_time = time_it([&]() { transpose(columns.view(), fb.view(img_w / 2, 0, img_w / 2, img_h)); });
+
+    const double pixels = double(img_w) * img_h;
+    std::cout << "render_frame " << img_w << "x" << img_h << ", " << rend.pool().size() << " threads\n"
+              << "    direct:        " << direct_time * 1e3 << " ms/frame, " << pixels / direct_time / 1e6 << " Mpixels/s\n"
+              << "    streaming clear: " << streaming_time * 1e3 << " ms/frame (x" << direct_time / streaming_time << ")\n"
+              << "    column-major:  " << transposed_time * 1e3 << " ms/frame, " << pixels / transposed_time / 1e6
+              << " Mpixels/s (x" << direct_time / transposed_time << ")\n"
+              << "    transpose alone (1 thread): " << transpose_time * 1e3 << " ms" << std::endl;
+}
+
+void bench_sprites(const scene &sc,
+                   const float x, const float y, const float view_angle, const float fov,
+                   const size_t img_w, const size_t img_h, const float max_dist, const size_t nsprites, const size_t nthreads)
+{
+    std::vector<sprite> sprites;
+    std::mt19937 rng(1);
+    while (sprites.size() < nsprites && sc.spritetext.count() > 0)
+    {
+        const float sx = std::uniform_real_distribution<float>(0.0f, float(sc.map.w))(rng);
+        const float sy = std::uniform_real_distribution<float>(0.0f, float(sc.map.h))(rng);
+        if (!sc.map.wall(size_t(sx), size_t(sy))) sprites.push_back({sx, sy, rng() % sc.spritetext.count()});
+    }
+
+    framebuffer img(img_w, img_h);
+    const camera cam = make_camera(x, y, view_angle, fov);
+    ray_table rays;
+    rays.update(cam, img_w);
+    std::vector<ray_hit> hits;
+    thread_pool pool(nthreads);
+    render_walls(img.view(), column_layout::row_major, sc, cam, rays, max_dist, pool, hits);
+    std::vector<float> depth(img_w);
+    for (size_t i = 0; i < img_w; i++) depth[i] = hits[i].hit ? hits[i].dist : INFINITY;
+
+    sprite_list list;
+    const double project_time = time_it([&]() { list.project(sprites, cam, img_w, img_h, depth.data(), max_dist); });
+    const double draw_time = time_it([&]() { draw_sprites(img.view(), column_layout::row_major, sc.spritetext, list.sorted(), depth.data(), pool); });
+    // the same projection without the depth buffer: every sprite in the view gets sorted and drawn
+    sprite_list unculled;
+    const double unculled_time = time_it([&]() { unculled.project(sprites, cam, img_w, img_h, nullptr, INFINITY); });
+    const double unculled_draw_time = time_it([&]() { draw_sprites(img.view(), column_layout::row_major, sc.spritetext, unculled.sorted(), depth.data(), pool); });
+
+    // the sort alone, on keys like the ones project() sorts
+    std::vector<uint32_t> keys(nsprites), values(nsprites), tmp_keys(nsprites), tmp_values(nsprites);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs(nsprites);
+    auto fill_keys = [&]()
+    {
+        std::mt19937 key_rng(2);
+        for (size_t i = 0; i < nsprites; i++)
+        {
+            const float d = std::uniform_real_distribution<float>(0.05f, max_dist)(key_rng);
+            uint32_t bits;
+            std::memcpy(&bits, &d, sizeof(bits));
+            keys[i] = ~bits;
+            values[i] = uint32_t(i);
+            pairs[i] = {keys[i], values[i]};
+        }
+    };
+    const double radix_time = time_it([&]() { fill_keys(); radix_sort(keys.data(), values.data(), nsprites, tmp_keys.data(), tmp_values.data()); });
+    const bool sorted = std::is_sorted(keys.begin(), keys.end());
+    const double std_time = time_it([&]() { fill_keys(); std::sort(pairs.begin(), pairs.end()); });
+    const double fill_time = time_it(fill_keys);
+
+    std::cout << "sprites: " << nsprites << " on a " << sc.map.w << "x" << sc.map.h << " map, " << img_w << "x" << img_h << ", "
+              << pool.size() << " threads\n"
+              << "    " << list.frustum_culled() << " out of the view, " << list.occluded() << " behind walls, "
+              << list.sorted().size() << " drawn (" << unculled.sorted().size() << " without occlusion culling)\n"
+              << "    project + sort: " << project_time * 1e3 << " ms, without occlusion culling: " << unculled_time * 1e3 << " ms\n"
+              << "    draw:           " << draw_time * 1e3 << " ms, without occlusion culling: " << unculled_draw_time * 1e3 << " ms\n"
+              << "    sort alone:     radix " << (radix_time - fill_time) * 1e3 << " ms" << (sorted ? "" : " (NOT SORTED)")
+              << ", std::sort " << (std_time - fill_time) * 1e3 << " ms" << std::endl;
+}
+
+void bench_entity_grid(const map_view &map,
+                       const float x, const float y, const float view_angle, const float fov,
+                       const size_t img_w, const size_t img_h, const float max_dist, const size_t nsprites)
+{
+    std::vector<sprite> sprites;
+    std::mt19937 rng(1);
+    while (sprites.size() < nsprites)
+    {
+        const float sx = std::uniform_real_distribution<float>(0.0f, float(map.w))(rng);
+        const float sy = std::uniform_real_distribution<float>(0.0f, float(map.h))(rng);
+        if (!map.wall(size_t(sx), size_t(sy))) sprites.push_back({sx, sy, 0});
+    }
+    const camera cam = make_camera(x, y, view_angle, fov);
+    const float margin = img_h * std::sqrt(cam.plane_x * cam.plane_x + cam.plane_y * cam.plane_y) / img_w;
+
+    sprite_list scan;
+    const double scan_time = time_it([&]() { scan.project(sprites, cam, img_w, img_h, nullptr, max_dist); });
+
+    entity_grid grid;
+    const double build_time = time_it([&]() { grid.build(map.w, map.h, sprites); });
+    sprite_list culled;
+    std::vector<uint32_t> ids;
+    std::vector<sprite> candidates;
+    size_t buckets = 0;
+    const double grid_time = time_it([&]()
+    {
+        ids.clear();
+        buckets = grid.query_view(cam, max_dist, margin, ids);
+        candidates.clear();
+        for (const uint32_t id : ids) candidates.push_back(sprites[id]);
+        culled.project(candidates, cam, img_w, img_h, nullptr, max_dist);
+    });
+    // same sprites drawn: the query is conservative, the order only differs between sprites at the same depth
+    bool same = scan.sorted().size() == culled.sorted().size();
+    for (size_t i = 0; same && i < scan.sorted().size(); i++) same = scan.sorted()[i].depth == culled.sorted()[i].depth;
+
+    // every sprite takes a small step, most of them stay in their bucket
+    std::vector<sprite> moved = sprites;
+    float step = 0.05f;
+    const double move_time = time_it([&]()
+    {
+        for (size_t i = 0; i < moved.size(); i++)
+        {
+            moved[i].x += (i & 1) ? step : -step;
+            moved[i].y += (i & 2) ? step : -step;
+            grid.move(uint32_t(i), moved[i].x, moved[i].y);
+        }
+        step = -step;
+    });
+
+    std::cout << "entity_grid: " << nsprites << " sprites on a " << map.w << "x" << map.h << " map, view distance " << max_dist << "\n"
+              << "    build:              " << build_time * 1e3 << " ms\n"
+              << "    scan + project:     " << scan_time * 1e3 << " ms, " << scan.sorted().size() << " in the view\n"
+              << "    query + project:    " << grid_time * 1e3 << " ms (x" << scan_time / grid_time << "), "
+              << buckets << " buckets, " << ids.size() << " candidates" << (same ? "" : ", DIFFERENT SPRITES") << "\n"
+              << "    move:               " << move_time / nsprites * 1e9 << " ns/sprite" << std::endl;
+}
+
+void bench_floor_ceiling(const scene &sc,
+                         const float x, const float y, const float view_angle, const float fov,
+                         const size_t img_w, const size_t img_h, const size_t nthreads)
+{
+    scene textured = sc;
+    if (textured.floor_texture >= textured.walltext.count()) textured.floor_texture = std::min<size_t>(5, textured.walltext.count() - 1);
+    if (textured.ceiling_texture >= textured.walltext.count()) textured.ceiling_texture = std::min<size_t>(1, textured.walltext.count() - 1);
+    const camera cam = make_camera(x, y, view_angle, fov);
+    framebuffer fb(img_w, img_h);
+    framebuffer columns(img_h, img_w);
+    thread_pool pool(nthreads);
+
+    const double pixels = double(img_w) * img_h;
+    const double flat_time = time_it([&]() { fill_sky_floor(fb.view(), column_layout::row_major, sc.ceiling_color, sc.floor_color, pool, false); });
+    std::cout << "floor and ceiling " << img_w << "x" << img_h << ", " << pool.size() << " threads\n"
+              << "    flat colors: " << flat_time * 1e3 << " ms, " << pixels / flat_time / 1e6 << " Mpixels/s" << std::endl;
+    const simd_level best = detect_simd_level();
+    for (int level = 0; level <= int(best); level += int(best))
+    {
+        set_simd_level(simd_level(level));
+        const double t = time_it([&]() { cast_floor_ceiling(fb.view(), column_layout::row_major, textured, cam, pool); });
+        std::cout << "    textured, " << simd_level_name(simd_level(level)) << ": " << t * 1e3 << " ms, " << pixels / t / 1e6 << " Mpixels/s" << std::endl;
+        if (best == simd_level::scalar) break;
+    }
+    set_simd_level(best);
+    const double transposed_time = time_it([&]() { cast_floor_ceiling(columns.view(), column_layout::column_major, textured, cam, pool); });
+    std::cout << "    textured, column-major: " << transposed_time * 1e3 << " ms, " << pixels / transposed_time / 1e6 << " Mpixels/s" << std::endl;
+}
+
+void bench_clear(const size_t img_w, const size_t img_h)
+{
+    framebuffer fb(img_w, img_h);
+    std::cout << "clear_image " << img_w << "x" << img_h << std::endl;
+    const simd_level best = detect_simd_level();
+    for (int level = 0; level <= int(best); level += int(best))
+    {
+        set_simd_level(simd_level(level));
+        for (int streaming = 0; streaming < 2; streaming++)
+        {
+            const double t = time_it([&]() { clear_image(fb.view(), pack_color(255, 255, 255), streaming != 0); });
+            std::cout << "    " << simd_level_name(simd_level(level)) << (streaming ? ", streaming: " : ":            ")
+                      << t * 1e3 << " ms, " << img_w * img_h * 4 / t / 1e9 << " GB/s" << std::endl;
+        }
+        if (best == simd_level::scalar) break;
+    }
+    set_simd_level(best);
+}
+
+void bench_encode_ppm(const size_t img_w, const size_t img_h)
+{
+    framebuffer img(img_w, img_h);
+    for (size_t j = 0; j < img_h; j++)
+    {
+        for (size_t i = 0; i < img_w; i++)
+        {
+            img.row(j)[i] = uint32_t((i + j * img_w) * 2654435761u);
+        }
+    }
+    std::vector<uint8_t> buffer;
+
+    std::cout << "encode_ppm " << img_w << "x" << img_h << std::endl;
+    const simd_level best = detect_simd_level();
+    for (int level = 0; level <= int(best); level++)
+    {
+        set_simd_level(simd_level(level));
+        const double t = time_it([&]() { encode_ppm(img, buffer); });
+        std::cout << "    " << simd_level_name(simd_level(level)) << ": " << t * 1e3 << " ms/frame, "
+                  << img_w * img_h * 4 / t / 1e9 << " GB/s" << std::endl;
+    }
+    set_simd_level(best);
+}
+
+void run_benchmarks(const scene &sc,
+                    const float x, const float y, const float view_angle, const float fov, const size_t nthreads)
+{
+    bench_raycast(sc.map, x, y, view_angle, fov, 512, 20.0f);
+
+    // a big open field with a few pillars, rays travel far before hitting anything
+    const size_t big_w = 256, big_h = 256;
+    map_grid big(big_w, big_h);
+    for (size_t j = 0; j < big_h; j++)
+    {
+        for (size_t i = 0; i < big_w; i++)
+        {
+            if (i == 0 || j == 0 || i == big_w - 1 || j == big_h - 1 || (i % 16 == 8 && j % 16 == 8))
+                big.set(i, j, uint8_t((i + j) % sc.walltext.count()));
+        }
+    }
+    const map_view big_map = big.view();
+    bench_raycast(big_map, big_w / 2 + 0.3f, big_h / 2 + 0.6f, view_angle, fov, 512, 200.0f);
+    scene big_sc = sc;
+    big_sc.map = big_map;
+
+    // the traversals on every kind of map: rooms, open fields and mazes, at the view distance of the game and far beyond it
+    bench_traversal("the game map", sc.map, x, y, 1024, 20.0f);
+    bench_traversal("pillars", big_map, big_w / 2 + 0.3f, big_h / 2 + 0.6f, 1024, 200.0f);
+    const size_t wide_w = 1025, wide_h = 1025;
+    map_grid field(wide_w, wide_h);
+    for (size_t j = 0; j < wide_h; j++)
+    {
+        for (size_t i = 0; i < wide_w; i++)
+        {
+            if (i == 0 || j == 0 || i == wide_w - 1 || j == wide_h - 1 || (i % 128 == 64 && j % 128 == 64))
+                field.set(i, j, uint8_t((i + j) % sc.walltext.count()));
+        }
+    }
+    map_grid maze;
+    make_maze(maze, wide_w, wide_h, sc.walltext.count());
+    for (const float max_dist : {20.0f, 2000.0f})
+    {
+        bench_traversal("open field", field.view(), wide_w / 2 + 0.3f, wide_h / 2 + 0.6f, 1024, max_dist);
+        bench_traversal("maze", maze.view(), wide_w / 2 + 1.3f, wide_h / 2 + 1.6f, 1024, max_dist); // in a room
+    }
+
+    bench_map_layout(4096, 4096, sc.walltext.count());
+
+    bench_render_walls(sc, x, y, view_angle, fov, 3840, 2160, 20.0f, nthreads);
+    bench_render_walls(big_sc, big_w / 2 + 0.3f, big_h / 2 + 0.6f, view_angle, fov, 3840, 2160, 200.0f, nthreads);
+    const size_t resolutions[][2] = {{1024, 512}, {1920, 1080}, {3840, 2160}, {7680, 4320}};
+    for (const auto &res : resolutions)
+    {
+        bench_render_target(sc, x, y, view_angle, fov, res[0], res[1], 20.0f, nthreads);
+    }
+    for (const size_t nsprites : {1000, 10000, 100000})
+    {
+        bench_sprites(big_sc, big_w / 2 + 0.3f, big_h / 2 + 0.6f, view_angle, fov, 1920, 1080, 200.0f, nsprites, nthreads);
+    }
+    for (const size_t nsprites : {10000, 1000000})
+    {
+        for (const float max_dist : {20.0f, 200.0f})
+        {
+            bench_entity_grid(field.view(), wide_w / 2 + 0.3f, wide_h / 2 + 0.6f, view_angle, fov, 1920, 1080, max_dist, nsprites);
+        }
+    }
+    bench_floor_ceiling(sc, x, y, view_angle, fov, 1024, 512, nthreads);
+    bench_floor_ceiling(sc, x, y, view_angle, fov, 3840, 2160, nthreads);
+    bench_clear(1024, 512);
+    bench_clear(7680, 4320);
+    bench_encode_ppm(1024, 512);
+}
@@ -0,0 +1,58 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstddef>
+
+#include "map.h"
+#include "render.h"
+
+// Times cast_ray() against the fixed step march_ray() over one frame worth of columns and prints the results
+void bench_raycast(const map_view &map,
+                   const float x, const float y, const float view_angle, const float fov,
+                   const size_t ncolumns, const float max_dist);
+
+// Times every traversal (see raycast.h) over nrays rays spread all around (x, y), along with building what they need
+void bench_traversal(const char *name, const map_view &map, const float x, const float y, const size_t nrays, const float max_dist);
+
+// Times cast_ray() on a map_w x map_h map with walls scattered at random, stored row-major and in tiles
+void bench_map_layout(const size_t map_w, const size_t map_h, const size_t nkinds);
+
+// Times render_walls() on a single thread against a pool of nthreads (0: one per core)
+void bench_render_walls(const scene &sc,
+                        const float x, const float y, const float view_angle, const float fov,
+                        const size_t img_w, const size_t img_h, const float max_dist, const size_t nthreads);
+
+// Times whole frames drawn directly into the frame against frames drawn column-major then transposed
+void bench_render_target(const scene &sc,
+                         const float x, const float y, const float view_angle, const float fov,
+                         const size_t img_w, const size_t img_h, const float max_dist, const size_t nthreads);
+
+// Scatters nsprites sprites over the empty cells of sc's map, then times their projection and culling, the radix sort
+// against std::sort, and drawing them over the walls
+void bench_sprites(const scene &sc,
+                   const float x, const float y, const float view_angle, const float fov,
+                   const size_t img_w, const size_t img_h, const float max_dist, const size_t nsprites, const size_t nthreads);
+
+// Scatters nsprites sprites over the empty cells of map, then times sprite_list::project() on all of them against
+// project() on the candidates of an entity_grid query for the view, and moving every sprite a little in the grid
+void bench_entity_grid(const map_view &map,
+                       const float x, const float y, const float view_angle, const float fov,
+                       const size_t img_w, const size_t img_h, const float max_dist, const size_t nsprites);
+
+// Times cast_floor_ceiling() with textures 5 and 1 of sc (or whatever it has), with and without simd, in both layouts,
+// against the flat colors of fill_sky_floor()
+void bench_floor_ceiling(const scene &sc,
+                         const float x, const float y, const float view_angle, const float fov,
+                         const size_t img_w, const size_t img_h, const size_t nthreads);
+
+// Times clear_image() with plain and streaming stores, with and without simd
+void bench_clear(const size_t img_w, const size_t img_h);
+
+// Times the P6 encoding of a frame at every simd level the host supports
+void bench_encode_ppm(const size_t img_w, const size_t img_h);
+
+// Runs every benchmark on the given scene, then on a bigger generated map
+void run_benchmarks(const scene &sc,
+                    const float x, const float y, const float view_angle, const float fov, const size_t nthreads);
+
+#endif // !BENCH_H
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "camera.h"
+#include "camera_path.h"
+#include "framebuffer.h"
+#include "game.h"
+#include "map_file.h"
+#include "render.h"
+#include "simd.h"
+
+// The yardstick for renderer changes: renders frames along a reproducible camera path with no I/O at all and reports
+// how long they took. Same scene as the game, same options for the renderer
+
+namespace
+{
+    // value at fraction q of the sorted times, nearest rank
+    double percentile(const std::vector<double> &sorted, const double q)
+    {
+        const size_t rank = size_t(q * sorted.size() + 0.5);
+        return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool suite = false;
+    size_t img_w = 1024;
+    size_t img_h = 512;
+    column_layout layout = column_layout::row_major;
+    size_t nthreads = 0; // 0: one render thread per core
+    size_t nframes = 300;
+    size_t nwarmup = 10; // frames rendered before the timed ones, not reported
+    traversal ray_mode = traversal::dda;
+    bool tiled = false;
+    bool flat = false;
+    std::string map_filename; // empty: the built-in map
+    std::string path_name = "walk"; // a path_kind or a file of poses
+    std::string save_path_filename;
+    uint32_t seed = 1;
+    size_t nsprites = 0; // monsters scattered over the map on top of the ones of the game
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--suite") suite = true;
+        else if (arg == "--width" && i + 1 < argc) img_w = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--height" && i + 1 < argc) img_h = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--column-major") layout = column_layout::column_major;
+        else if (arg == "--threads" && i + 1 < argc) nthreads = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--frames" && i + 1 < argc) nframes = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--warmup" && i + 1 < argc) nwarmup = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--traversal" && i + 1 < argc && traversal_from_name(argv[i + 1], ray_mode)) i++;
+        else if (arg == "--tiled") tiled = true;
+        else if (arg == "--flat") flat = true;
+        else if (arg == "--map" && i + 1 < argc) map_filename = argv[++i];
+        else if (arg == "--path" && i + 1 < argc) path_name = argv[++i];
+        else if (arg == "--save-path" && i + 1 < argc) save_path_filename = argv[++i];
+        else if (arg == "--seed" && i + 1 < argc) seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--sprites" && i + 1 < argc) nsprites = strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--suite] [--map FILE] [--width W] [--height H] [--threads N] [--column-major] [--traversal march|dda|coarse|distance-field] [--tiled] [--flat] [--frames N] [--warmup N] [--path turn|walk|FILE] [--seed S] [--save-path FILE] [--sprites N]" << std::endl;
+            return -1;
+        }
+    }
+    if (img_w < 2 || img_h < 1 || nframes == 0)
+    {
+        std::cerr << "Error: the frame must be at least 2x1 pixels and there must be at least one frame" << std::endl;
+        return -1;
+    }
+
+    camera_pose start{game_start_x, game_start_y, game_start_angle};
+    scene sc;
+    sc.map = game_map.view();
+    map_file file;
+    if (!map_filename.empty())
+    {
+        if (!file.load(map_filename)) return -1;
+        sc.map = file.view();
+        if (file.has_start())
+        {
+            start.x = file.start_x() + 0.5f;
+            start.y = file.start_y() + 0.5f;
+        }
+    }
+    if (!load_scene_assets(sc, flat)) return -1;
+    if (map_filename.empty()) sc.sprites = game_sprites();
+    std::mt19937 rng(seed);
+    const size_t max_tries = 100 * nsprites; // a map with hardly any room gets fewer
+    for (size_t tries = 0, added = 0; added < nsprites && tries < max_tries && sc.spritetext.count() > 0; tries++)
+    {
+        const size_t x = rng() % sc.map.w, y = rng() % sc.map.h;
+        if (sc.map.wall(x, y)) continue;
+        sc.sprites.push_back({x + 0.5f, y + 0.5f, rng() % sc.spritetext.count()});
+        added++;
+    }
+
+    if (suite)
+    {
+        run_benchmarks(sc, start.x, start.y, start.angle, game_fov, nthreads);
+        return 0;
+    }
+
+    sc.ray_mode = ray_mode;
+    scene_structures structs;
+    build_scene_structures(sc, structs, tiled);
+
+    std::vector<camera_pose> path;
+    path_kind kind;
+    const bool generated = path_kind_from_name(path_name, kind);
+    if (generated) path = make_camera_path(sc.map, start, nframes, kind, seed);
+    else if (!load_camera_path(path_name, path)) return -1;
+    if (!save_path_filename.empty() && !save_camera_path(save_path_filename, path)) return -1;
+
+    // the path loops if it is shorter than the run
+    framebuffer fb(img_w, img_h);
+    renderer rend(nthreads, layout);
+    auto render = [&](const size_t frame)
+    {
+        const camera_pose &pose = path[frame % path.size()];
+        rend.render_frame(fb, sc, make_camera(pose.x, pose.y, pose.angle, game_fov), game_view_distance);
+    };
+    for (size_t frame = 0; frame < nwarmup; frame++) render(frame);
+
+    using clock = std::chrono::steady_clock;
+    std::vector<double> times(nframes);
+    const auto run_start = clock::now();
+    for (size_t frame = 0; frame < nframes; frame++)
+    {
+        const auto frame_start = clock::now();
+        render(frame);
+        times[frame] = std::chrono::duration<double>(clock::now() - frame_start).count();
+    }
+    const double total = std::chrono::duration<double>(clock::now() - run_start).count();
+    std::sort(times.begin(), times.end());
+
+    // one ray per column of the 3d view, the right half of the frame
+    const double rays = double(img_w - img_w / 2) * nframes;
+    const double pixels = double(img_w) * img_h * nframes;
+    std::cout << "map " << sc.map.w << "x" << sc.map.h << ", " << sc.sprites.size() << " sprites, " << img_w << "x" << img_h << ", "
+              << rend.pool().size() << " threads, " << traversal_name(ray_mode) << (tiled ? " tiled" : "") << ", "
+              << (layout == column_layout::column_major ? "column-major" : "row-major") << ", " << simd_level_name(get_simd_level())
+              << ", path " << path_name << (generated ? " (seed " + std::to_string(seed) + ")" : "") << ", " << nframes << " frames after " << nwarmup << " warm-up\n"
+              << "    frame time: mean " << total / nframes * 1e3 << " ms, p50 " << percentile(times, 0.50) * 1e3
+              << " ms, p90 " << percentile(times, 0.90) * 1e3 << " ms, p99 " << percentile(times, 0.99) * 1e3
+              << " ms, max " << times.back() * 1e3 << " ms\n"
+              << "    " << nframes / total << " frames/s, " << rays / total / 1e6 << " Mrays/s, " << pixels / total / 1e6 << " Mpixels/s" << std::endl;
+    return 0;
+}
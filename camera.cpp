@@ -0,0 +1,46 @@
+#include "camera.h"
+
+#include <cmath>
+
+camera make_camera(const float x, const float y, const float view_angle, const float fov)
+{
+    camera cam;
+    cam.x = x;
+    cam.y = y;
+    cam.dir_x = cosf(view_angle);
+    cam.dir_y = sinf(view_angle);
+    // the plane is the view direction rotated by +90 degrees, so the left column sits at view_angle - fov / 2
+    const float half_width = tanf(fov / 2);
+    cam.plane_x = -cam.dir_y * half_width;
+    cam.plane_y = cam.dir_x * half_width;
+    return cam;
+}
+
+void ray_table::update(const camera &cam, const size_t ncolumns)
+{
+    bool dirty = false;
+    if (mCameraX.size() != ncolumns)
+    {
+        mCameraX.resize(ncolumns);
+        for (size_t i = 0; i < ncolumns; i++)
+        {
+            mCameraX[i] = 2.0f * i / float(ncolumns) - 1.0f;
+        }
+        mDirX.resize(ncolumns);
+        mDirY.resize(ncolumns);
+        dirty = true;
+    }
+
+    dirty |= cam.dir_x != mCamDirX || cam.dir_y != mCamDirY || cam.plane_x != mPlaneX || cam.plane_y != mPlaneY;
+    if (!dirty) return;
+
+    for (size_t i = 0; i < ncolumns; i++)
+    {
+        mDirX[i] = cam.dir_x + cam.plane_x * mCameraX[i];
+        mDirY[i] = cam.dir_y + cam.plane_y * mCameraX[i];
+    }
+    mCamDirX = cam.dir_x;
+    mCamDirY = cam.dir_y;
+    mPlaneX = cam.plane_x;
+    mPlaneY = cam.plane_y;
+}
@@ -0,0 +1,43 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <cstddef>
+#include <vector>
+
+// Camera plane model: a unit view direction plus a plane vector perpendicular to it.
+// The ray of a screen column is dir + plane * camera_x with camera_x going from -1 (left) to 1 (right),
+// so |plane| = tan(fov / 2). Since dir has unit length, the DDA distance along such a ray is already the
+// perpendicular distance to the camera plane: no fish eye correction needed.
+struct camera
+{
+    float x = 0.0f; // position in map cells
+    float y = 0.0f;
+    float dir_x = 1.0f;
+    float dir_y = 0.0f;
+    float plane_x = 0.0f;
+    float plane_y = 1.0f;
+};
+
+// the only place where the view angle and fov go through trigonometry
+camera make_camera(const float x, const float y, const float view_angle, const float fov);
+
+// Ray direction of every screen column, stored as two flat arrays.
+// update() is meant to be called every frame, it only does work when something changed:
+// camera_x per column is rebuilt on resolution changes, the directions when the camera turns or the fov changes.
+class ray_table
+{
+public:
+    void update(const camera &cam, const size_t ncolumns);
+
+    size_t size() const { return mDirX.size(); }
+    const float *dir_x() const { return mDirX.data(); }
+    const float *dir_y() const { return mDirY.data(); }
+
+private:
+    std::vector<float> mCameraX; // [-1, 1) across the screen, only depends on the number of columns
+    std::vector<float> mDirX;
+    std::vector<float> mDirY;
+    float mCamDirX = 0.0f, mCamDirY = 0.0f, mPlaneX = 0.0f, mPlaneY = 0.0f; // what mDirX/mDirY were built for
+};
+
+#endif // !CAMERA_H
@@ -0,0 +1,137 @@
+#include "camera_path.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    constexpr float two_pi = 6.28318531f;
+    constexpr float walk_speed = 0.05f;     // cells per frame
+    constexpr float walk_lookahead = 0.5f;  // cells ahead that must be free to keep walking
+    constexpr float walk_wobble = 0.03f;    // largest random turn per frame, radians
+    constexpr float walk_turn = two_pi / 16; // turn step away from a wall
+
+    bool blocked(const map_view &map, const float x, const float y)
+    {
+        if (!(x >= 0.0f && y >= 0.0f && x < float(map.w) && y < float(map.h))) return true;
+        return map.wall(size_t(x), size_t(y));
+    }
+
+    // uniform in [-1, 1] from the raw output of the generator: the std distributions differ from one standard
+    // library to the next, the generator itself does not
+    float unit_noise(std::mt19937 &rng)
+    {
+        return float(int(rng() % 2001) - 1000) / 1000.0f;
+    }
+}
+
+const char *path_kind_name(const path_kind kind)
+{
+    switch (kind)
+    {
+        case path_kind::turn: return "turn";
+        case path_kind::walk: return "walk";
+    }
+    return "unknown";
+}
+
+bool path_kind_from_name(const std::string &name, path_kind &kind)
+{
+    for (const path_kind candidate : {path_kind::turn, path_kind::walk})
+    {
+        if (name == path_kind_name(candidate))
+        {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<camera_pose> make_camera_path(const map_view &map, const camera_pose start, const size_t nframes,
+                                          const path_kind kind, const uint32_t seed)
+{
+    std::vector<camera_pose> path(nframes, start);
+    if (kind == path_kind::turn)
+    {
+        for (size_t i = 0; i < nframes; i++) path[i].angle = start.angle + two_pi * i / nframes;
+        return path;
+    }
+
+    std::mt19937 rng(seed);
+    camera_pose pose = start;
+    for (size_t i = 0; i < nframes; i++)
+    {
+        path[i] = pose;
+        pose.angle += walk_wobble * unit_noise(rng);
+        if (!blocked(map, pose.x + walk_lookahead * std::cos(pose.angle), pose.y + walk_lookahead * std::sin(pose.angle)))
+        {
+            pose.x += walk_speed * std::cos(pose.angle);
+            pose.y += walk_speed * std::sin(pose.angle);
+            continue;
+        }
+        // a wall ahead: this frame turns away from it on the spot, to the left or the right at random
+        const float turn = (rng() & 1) ? walk_turn : -walk_turn;
+        for (int tries = 0; tries < 16; tries++)
+        {
+            pose.angle += turn;
+            if (!blocked(map, pose.x + walk_lookahead * std::cos(pose.angle), pose.y + walk_lookahead * std::sin(pose.angle))) break;
+        }
+    }
+    return path;
+}
+
+bool load_camera_path(const std::string filename, std::vector<camera_pose> &path)
+{
+    std::ifstream ifs(filename);
+    if (!ifs)
+    {
+        std::cerr << "Error: can not open " << filename << std::endl;
+        return false;
+    }
+    path.clear();
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(ifs, line))
+    {
+        line_number++;
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        camera_pose pose;
+        if (!(fields >> pose.x >> pose.y >> pose.angle))
+        {
+            std::cerr << "Error: line " << line_number << " of " << filename << " is not \"x y angle\"" << std::endl;
+            return false;
+        }
+        path.push_back(pose);
+    }
+    if (path.empty())
+    {
+        std::cerr << "Error: " << filename << " has no camera pose" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool save_camera_path(const std::string filename, const std::vector<camera_pose> &path)
+{
+    std::ofstream ofs(filename);
+    if (!ofs)
+    {
+        std::cerr << "Error: can not create " << filename << std::endl;
+        return false;
+    }
+    // enough digits for every float to read back exactly
+    ofs.precision(std::numeric_limits<float>::max_digits10);
+    for (const camera_pose &pose : path) ofs << pose.x << ' ' << pose.y << ' ' << pose.angle << '\n';
+    if (!ofs)
+    {
+        std::cerr << "Error: can not write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "map.h"
+
+// Where the player stands and looks in one frame: make_camera() turns it into a camera
+struct camera_pose
+{
+    float x = 0.0f; // position in map cells
+    float y = 0.0f;
+    float angle = 0.0f; // angle between the view direction and the x axis
+};
+
+enum class path_kind
+{
+    turn, // stays where it starts and turns around once over the path, like the animation of the game
+    walk, // walks the map from where it starts, turning away from the walls
+};
+
+const char *path_kind_name(const path_kind kind);
+bool path_kind_from_name(const std::string &name, path_kind &kind); // false for an unknown name
+
+// nframes poses from start. A walk takes its turns from a std::mt19937 seeded with seed and reads nothing else but
+// the map: the same map, start and seed give the same path from one run to the next. Save it to replay it elsewhere,
+// cos and sin may round differently in another math library
+std::vector<camera_pose> make_camera_path(const map_view &map, const camera_pose start, const size_t nframes,
+                                          const path_kind kind, const uint32_t seed);
+
+// text files of one "x y angle" pose per line, to replay exactly the same path whatever made it.
+// Return false (and say why) on failure
+bool load_camera_path(const std::string filename, std::vector<camera_pose> &path);
+bool save_camera_path(const std::string filename, const std::vector<camera_pose> &path);
+
+#endif // !CAMERA_PATH_H
@@ -0,0 +1,46 @@
+#include "coarse_grid.h"
+
+void coarse_grid::build(const map_view &map)
+{
+    mLevels = 0;
+    const size_t map_size = map.w > map.h ? map.w : map.h;
+    for (int level = 1; level <= max_coarse_levels; level++)
+    {
+        const size_t block = size_t(1) << (level * coarse_shift);
+        if (block >= map_size) break; // a single block over the whole map, it's never empty in a map worth skipping in
+
+        grid &g = mGrids[level - 1];
+        g.w = (map.w + block - 1) / block;
+        g.h = (map.h + block - 1) / block;
+        g.walls.assign(g.w * g.h, 0);
+        if (level == 1)
+        {
+            // a byte of a word of occupancy bits is the row of 8 cells of a block. Padding bits past the end of a row
+            // are zero in a valid map, a damaged binary one may have some: they must not reach a block past g.w
+            for (size_t y = 0; y < map.h; y++)
+            {
+                const uint64_t *row = map.rows + y * map.row_words;
+                uint8_t *walls = &g.walls[(y >> coarse_shift) * g.w];
+                for (size_t i = 0; i < map.row_words; i++)
+                {
+                    for (size_t b = 0; b < 8 && i * 8 + b < g.w && row[i] >> (b * 8); b++)
+                    {
+                        if ((row[i] >> (b * 8)) & 0xff) walls[i * 8 + b] = 1;
+                    }
+                }
+            }
+        }
+        else
+        {
+            const grid &below = mGrids[level - 2];
+            for (size_t y = 0; y < below.h; y++)
+            {
+                for (size_t x = 0; x < below.w; x++)
+                {
+                    if (below.walls[x + y * below.w]) g.walls[(x >> coarse_shift) + (y >> coarse_shift) * g.w] = 1;
+                }
+            }
+        }
+        mLevels = level;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef COARSE_GRID_H
+#define COARSE_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "map.h"
+
+constexpr int coarse_shift = 3;      // a block of a level is 8x8 blocks of the level below, level 0 being the cells
+constexpr int max_coarse_levels = 4; // blocks of up to 4096x4096 cells
+
+// Empty-space skipping for long rays: a pyramid of coarse occupancy grids over a map. Block (bx, by) of level l
+// covers the cells (bx << (l * coarse_shift), by << (l * coarse_shift)) and the 8^l x 8^l after them, it is empty
+// when none of them is a wall. A ray in an empty block can go straight to the edge of the block in one step.
+// Built from a map_view and not kept in sync with it: rebuild it when the map changes.
+class coarse_grid
+{
+public:
+    coarse_grid() = default;
+    explicit coarse_grid(const map_view &map) { build(map); }
+
+    void build(const map_view &map);
+
+    // levels above the cells, only as many as the map needs: the blocks of the last one are smaller than the map
+    int levels() const { return mLevels; }
+
+    // level in [1, levels()], (bx, by) a block of it, i.e. a cell of the map shifted by level * coarse_shift
+    bool empty(const int level, const size_t bx, const size_t by) const
+    {
+        const grid &g = mGrids[level - 1];
+        return !g.walls[bx + by * g.w];
+    }
+
+private:
+    struct grid
+    {
+        std::vector<uint8_t> walls; // 1 if the block has a wall in it
+        size_t w = 0;
+        size_t h = 0;
+    };
+
+    grid mGrids[max_coarse_levels];
+    int mLevels = 0;
+};
+
+#endif // !COARSE_GRID_H
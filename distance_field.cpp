@@ -0,0 +1,70 @@
+#include "distance_field.h"
+
+#include <algorithm>
+
+namespace
+{
+    // one pass of the transform over a row, from the row before it in the pass (nullptr for the first one): each
+    // cell gets one more than the smallest of its three neighbours there and of the cell before it in the row, which
+    // is on the left going forward and on the right going backward
+    void chamfer_row(uint8_t *row, const uint8_t *before, const int w, const bool forward)
+    {
+        if (before)
+        {
+            // the three neighbours in the row before don't depend on each other, this part vectorizes
+            int prev = before[0];
+            for (int x = 0; x < w; x++)
+            {
+                const int next = x + 1 < w ? before[x + 1] : max_field_distance;
+                const int d = std::min(std::min(prev, int(before[x])), next) + 1;
+                prev = before[x];
+                row[x] = uint8_t(std::min(int(row[x]), d));
+            }
+        }
+        // each cell depends on the one just written, carried in a register rather than read back
+        if (forward)
+        {
+            int d = row[0];
+            for (int x = 1; x < w; x++)
+            {
+                d = std::min(int(row[x]), d + 1);
+                row[x] = uint8_t(d);
+            }
+        }
+        else
+        {
+            int d = row[w - 1];
+            for (int x = w - 2; x >= 0; x--)
+            {
+                d = std::min(int(row[x]), d + 1);
+                row[x] = uint8_t(d);
+            }
+        }
+    }
+}
+
+void distance_field::build(const map_view &map)
+{
+    mW = map.w;
+    mH = map.h;
+    mDist.resize(mW * mH);
+    for (size_t i = 0; i < mW * mH; i++)
+    {
+        mDist[i] = map.cells[i] == empty_cell ? max_field_distance : 0;
+    }
+
+    // a chamfer transform: the distance of a cell is one more than the smallest of its 8 neighbours. The first pass
+    // looks at the neighbours above and on the left, the second one at those below and on the right. For the
+    // Chebyshev distance, where every neighbour is one step away, that's exact
+    const int w = int(mW), h = int(mH);
+    for (int y = 0; y < h; y++)
+    {
+        uint8_t *row = &mDist[y * mW];
+        chamfer_row(row, y > 0 ? row - mW : nullptr, w, true);
+    }
+    for (int y = h - 1; y >= 0; y--)
+    {
+        uint8_t *row = &mDist[y * mW];
+        chamfer_row(row, y + 1 < h ? row + mW : nullptr, w, false);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "map.h"
+
+constexpr uint8_t max_field_distance = 255; // distances saturate here, the field takes a byte per cell
+
+// Chebyshev distance from every cell of a map to the nearest wall, in cells: 0 for walls, 1 for the cells around
+// them (diagonals included), 2 for the ring around those and so on. A cell at distance d sits in the middle of a
+// square of 2d - 1 by 2d - 1 empty cells, which is what rays sphere trace on: Chebyshev balls are squares, and a
+// ray leaves a square with the same arithmetic as a grid cell. Computed in linear time, two passes over the map.
+// Built from a map_view and not kept in sync with it: rebuild it when the map changes.
+class distance_field
+{
+public:
+    distance_field() = default;
+    explicit distance_field(const map_view &map) { build(map); }
+
+    void build(const map_view &map);
+
+    uint8_t at(const size_t x, const size_t y) const { return mDist[x + y * mW]; }
+
+private:
+    std::vector<uint8_t> mDist;
+    size_t mW = 0;
+    size_t mH = 0;
+};
+
+#endif // !DISTANCE_FIELD_H
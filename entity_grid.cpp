@@ -0,0 +1,139 @@
+#include "entity_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+void entity_grid::reset(const size_t map_w, const size_t map_h)
+{
+    const size_t bucket = size_t(1) << entity_bucket_shift;
+    mBucketsW = std::max<size_t>(1, (map_w + bucket - 1) / bucket);
+    mBucketsH = std::max<size_t>(1, (map_h + bucket - 1) / bucket);
+    mHeads.assign(mBucketsW * mBucketsH, no_entity);
+    mNext.clear();
+    mPrev.clear();
+    mBucketOf.clear();
+    mSize = 0;
+}
+
+void entity_grid::build(const size_t map_w, const size_t map_h, const std::vector<sprite> &sprites)
+{
+    reset(map_w, map_h);
+    mNext.resize(sprites.size());
+    mPrev.resize(sprites.size());
+    mBucketOf.assign(sprites.size(), no_entity);
+    for (size_t i = 0; i < sprites.size(); i++) insert(uint32_t(i), sprites[i].x, sprites[i].y);
+}
+
+uint32_t entity_grid::bucket(const float x, const float y) const
+{
+    // clamped in float first: the conversion of a float out of the range of the int is undefined
+    const float max_x = float(mBucketsW << entity_bucket_shift) - 1.0f;
+    const float max_y = float(mBucketsH << entity_bucket_shift) - 1.0f;
+    const size_t cx = size_t(std::min(std::max(x, 0.0f), max_x));
+    const size_t cy = size_t(std::min(std::max(y, 0.0f), max_y));
+    return uint32_t((cx >> entity_bucket_shift) + (cy >> entity_bucket_shift) * mBucketsW);
+}
+
+void entity_grid::link(const uint32_t id, const uint32_t b)
+{
+    mBucketOf[id] = b;
+    mPrev[id] = no_entity;
+    mNext[id] = mHeads[b];
+    if (mHeads[b] != no_entity) mPrev[mHeads[b]] = id;
+    mHeads[b] = id;
+}
+
+void entity_grid::unlink(const uint32_t id)
+{
+    const uint32_t b = mBucketOf[id];
+    if (mPrev[id] != no_entity) mNext[mPrev[id]] = mNext[id];
+    else mHeads[b] = mNext[id];
+    if (mNext[id] != no_entity) mPrev[mNext[id]] = mPrev[id];
+    mBucketOf[id] = no_entity;
+}
+
+void entity_grid::insert(const uint32_t id, const float x, const float y)
+{
+    if (id >= mBucketOf.size())
+    {
+        mNext.resize(id + 1);
+        mPrev.resize(id + 1);
+        mBucketOf.resize(id + 1, no_entity);
+    }
+    if (mBucketOf[id] != no_entity)
+    { // already in, it just moved
+        move(id, x, y);
+        return;
+    }
+    link(id, bucket(x, y));
+    mSize++;
+}
+
+void entity_grid::move(const uint32_t id, const float x, const float y)
+{
+    const uint32_t b = bucket(x, y);
+    if (b == mBucketOf[id]) return; // most moves stay within a bucket
+    unlink(id);
+    link(id, b);
+}
+
+void entity_grid::remove(const uint32_t id)
+{
+    if (!contains(id)) return;
+    unlink(id);
+    mSize--;
+}
+
+size_t entity_grid::query_view(const camera &cam, const float max_dist, const float margin, std::vector<uint32_t> &ids) const
+{
+    // the view triangle: the camera, and the far plane from the left ray to the right one, see ray_table
+    const float px[3] = {cam.x, cam.x + max_dist * (cam.dir_x - cam.plane_x), cam.x + max_dist * (cam.dir_x + cam.plane_x)};
+    const float py[3] = {cam.y, cam.y + max_dist * (cam.dir_y - cam.plane_y), cam.y + max_dist * (cam.dir_y + cam.plane_y)};
+    const float bucket = float(size_t(1) << entity_bucket_shift);
+
+    // the rows of buckets the triangle spans, grown by margin, clamped to the grid in float before the conversions
+    auto clamp_bucket = [&](const float v, const size_t nbuckets)
+    {
+        return size_t(std::min(std::max(std::floor(v / bucket), 0.0f), float(nbuckets - 1)));
+    };
+    const float min_y = std::min({py[0], py[1], py[2]}) - margin;
+    const float max_y = std::max({py[0], py[1], py[2]}) + margin;
+    const size_t by0 = clamp_bucket(min_y, mBucketsH), by1 = clamp_bucket(max_y, mBucketsH);
+
+    size_t visited = 0;
+    for (size_t by = by0; by <= by1; by++)
+    {
+        // the x extent of the triangle within the slab of the row: from its vertices inside the slab and from where
+        // its edges cross the borders of the slab. A convex polygon, nothing else can stick out further.
+        // Entities off the map are in the buckets on its border, whose slabs go on forever past the border
+        const float y0 = by == 0 ? -INFINITY : by * bucket - margin;
+        const float y1 = by == mBucketsH - 1 ? INFINITY : (by + 1) * bucket + margin;
+        float lo = INFINITY, hi = -INFINITY;
+        for (int i = 0; i < 3; i++)
+        {
+            if (py[i] >= y0 && py[i] <= y1)
+            {
+                lo = std::min(lo, px[i]);
+                hi = std::max(hi, px[i]);
+            }
+            const int j = (i + 1) % 3;
+            if (py[i] == py[j]) continue;
+            for (const float yb : {y0, y1})
+            {
+                if ((yb - py[i]) * (yb - py[j]) > 0.0f) continue; // the edge doesn't reach this border
+                const float x = px[i] + (yb - py[i]) * (px[j] - px[i]) / (py[j] - py[i]);
+                lo = std::min(lo, x);
+                hi = std::max(hi, x);
+            }
+        }
+        if (lo > hi) continue; // the triangle doesn't cross this row
+
+        const size_t bx0 = clamp_bucket(lo - margin, mBucketsW), bx1 = clamp_bucket(hi + margin, mBucketsW);
+        for (size_t bx = bx0; bx <= bx1; bx++)
+        {
+            visited++;
+            for (uint32_t id = mHeads[bx + by * mBucketsW]; id != no_entity; id = mNext[id]) ids.push_back(id);
+        }
+    }
+    return visited;
+}
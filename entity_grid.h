@@ -0,0 +1,63 @@
+#ifndef ENTITY_GRID_H
+#define ENTITY_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "camera.h"
+#include "sprite.h"
+
+constexpr size_t entity_bucket_shift = 3; // a bucket is 8x8 map cells, like a tile of tiled_map
+constexpr uint32_t no_entity = UINT32_MAX;
+
+// Uniform grid over the entities of a map, in the cell coordinates of the map: entity id goes into the bucket of
+// cell (x, y) shifted by entity_bucket_shift, entities off the map into the nearest bucket on its border.
+// Each bucket is an intrusive doubly linked list threaded through per-entity arrays, so inserting, moving and removing
+// an entity is O(1) and allocates nothing once the arrays are big enough. Ids are whatever the caller indexes its
+// entities with, typically their position in scene::sprites
+class entity_grid
+{
+public:
+    entity_grid() = default;
+    entity_grid(const size_t map_w, const size_t map_h) { reset(map_w, map_h); }
+    entity_grid(const size_t map_w, const size_t map_h, const std::vector<sprite> &sprites) { build(map_w, map_h, sprites); }
+
+    // an empty grid over a map_w x map_h map
+    void reset(const size_t map_w, const size_t map_h);
+    // sprite i gets id i
+    void build(const size_t map_w, const size_t map_h, const std::vector<sprite> &sprites);
+
+    void insert(const uint32_t id, const float x, const float y);
+    void move(const uint32_t id, const float x, const float y); // only touches the lists when the bucket changes
+    void remove(const uint32_t id);
+    bool contains(const uint32_t id) const { return id < mBucketOf.size() && mBucketOf[id] != no_entity; }
+    size_t size() const { return mSize; }
+
+    size_t buckets_w() const { return mBucketsW; }
+    size_t buckets_h() const { return mBucketsH; }
+    // first entity of bucket (bx, by), then next() until no_entity
+    uint32_t first(const size_t bx, const size_t by) const { return mHeads[bx + by * mBucketsW]; }
+    uint32_t next(const uint32_t id) const { return mNext[id]; }
+
+    // Appends to ids the entities of every bucket the view of cam crosses: the triangle from the camera to the
+    // far plane at depth max_dist, between the rays dir - plane and dir + plane (view_angle -/+ fov / 2), grown by
+    // margin on every side to catch entities whose center is outside but whose billboard is not.
+    // Conservative: sprite_list::project() still culls each candidate exactly. Returns the number of buckets visited
+    size_t query_view(const camera &cam, const float max_dist, const float margin, std::vector<uint32_t> &ids) const;
+
+private:
+    uint32_t bucket(const float x, const float y) const;
+    void link(const uint32_t id, const uint32_t b);
+    void unlink(const uint32_t id);
+
+    std::vector<uint32_t> mHeads;    // first entity of each bucket
+    std::vector<uint32_t> mNext;     // per entity: next and previous one in its bucket
+    std::vector<uint32_t> mPrev;
+    std::vector<uint32_t> mBucketOf; // per entity: its bucket, no_entity if it isn't in the grid
+    size_t mBucketsW = 0;
+    size_t mBucketsH = 0;
+    size_t mSize = 0;
+};
+
+#endif // !ENTITY_GRID_H
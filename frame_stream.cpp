@@ -0,0 +1,134 @@
+#include "frame_stream.h"
+#include "image.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+    // full frame 4:4:4 planes, BT.601 limited range
+    void encode_y4m_frame(const framebuffer &frame, std::vector<uint8_t> &buffer)
+    {
+        static const char tag[] = "FRAME\n";
+        const size_t header = sizeof(tag) - 1;
+        const size_t w = frame.width();
+        const size_t n = w * frame.height();
+        buffer.resize(header + n * 3);
+        std::copy(tag, tag + header, buffer.begin());
+
+        uint8_t *y = buffer.data() + header;
+        uint8_t *u = y + n;
+        uint8_t *v = u + n;
+        for (size_t j = 0; j < frame.height(); j++)
+        {
+            const uint32_t *row = frame.row(j);
+            for (size_t i = 0; i < w; i++, y++, u++, v++)
+            {
+                const int r = (row[i] >> 0) & 255;
+                const int g = (row[i] >> 8) & 255;
+                const int b = (row[i] >> 16) & 255;
+                *y = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                *u = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                *v = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+    }
+}
+
+bool frame_stream::open(const std::string filename, const stream_format format, const size_t w, const size_t h,
+                        const unsigned fps, const size_t queue_size, const async_writer::full_policy policy)
+{
+    close();
+    mFilename = filename;
+    if (format == stream_format::ppm_files)
+    {
+        mFile = nullptr;
+        mOwnsFile = false;
+    }
+    else if (filename == "-")
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        mFile = stdout;
+        mOwnsFile = false;
+    }
+    else
+    {
+        mFile = fopen(filename.c_str(), "wb");
+        mOwnsFile = true;
+    }
+    if (!mFile && format != stream_format::ppm_files)
+    {
+        std::cerr << "Error: can not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    mFormat = format;
+    mWidth = w;
+    mHeight = h;
+    mFailed = false;
+
+    if (format == stream_format::y4m)
+    {
+        const std::string header = "YUV4MPEG2 W" + std::to_string(w) + " H" + std::to_string(h) +
+                                   " F" + std::to_string(fps) + ":1 Ip A1:1 C444\n";
+        if (fwrite(header.data(), 1, header.size(), mFile) != header.size())
+        {
+            std::cerr << "Error: failed to write the stream header" << std::endl;
+            if (mOwnsFile) fclose(mFile);
+            mFile = nullptr;
+            return false;
+        }
+    }
+
+    mClosed = false;
+    mWriter.reset(new async_writer(w, h, queue_size, policy,
+                                   [this](const framebuffer &frame, const size_t index) { return write_frame(frame, index); }));
+    return true;
+}
+
+framebuffer &frame_stream::acquire()
+{
+    assert(mWriter);
+    return mWriter->acquire();
+}
+
+bool frame_stream::submit(framebuffer &frame)
+{
+    assert(mWriter && frame.width() == mWidth && frame.height() == mHeight);
+    return mWriter->submit(frame);
+}
+
+bool frame_stream::close()
+{
+    if (!mWriter || mClosed) return !mFailed;
+    mClosed = true;
+    if (!mWriter->finish()) mFailed = true;
+
+    if (mFile && fflush(mFile) != 0) mFailed = true;
+    if (mFile && mOwnsFile && fclose(mFile) != 0) mFailed = true;
+    mFile = nullptr;
+    if (mFailed) std::cerr << "Error: failed to write the frame stream" << std::endl;
+    return !mFailed;
+}
+
+bool frame_stream::write_frame(const framebuffer &frame, const size_t index)
+{
+    if (mFormat == stream_format::ppm_files)
+    {
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), "_%05u.ppm", unsigned(index));
+        return create_ppm_image(mFilename + suffix, frame, mBuffer);
+    }
+
+    if (mFormat == stream_format::y4m) encode_y4m_frame(frame, mBuffer);
+    else encode_ppm(frame, mBuffer);
+    return fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) == mBuffer.size();
+}
@@ -0,0 +1,61 @@
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "async_writer.h"
+
+enum class stream_format
+{
+    ppm, // P6 frames one after the other, what "ffmpeg -f image2pipe" reads
+    y4m, // YUV4MPEG2, 4:4:4, what most encoders take on stdin
+    ppm_files, // one P6 file per frame, <filename>_00000.ppm, <filename>_00001.ppm...
+};
+
+// Writes a sequence of frames to a file, to stdout or to one file per frame, through an async_writer.
+// Frames are rendered right into the buffers of its pool: acquire() one, draw into it, submit() it. The next frame
+// renders while the previous ones are being encoded and written, the renderer only waits once queue_size frames are
+// pending.
+class frame_stream
+{
+public:
+    frame_stream() = default;
+    ~frame_stream() { close(); }
+    frame_stream(const frame_stream &) = delete;
+    frame_stream &operator=(const frame_stream &) = delete;
+
+    // "-" writes to stdout (not with ppm_files). Returns false (and says why) if the file can't be opened
+    bool open(const std::string filename, const stream_format format, const size_t w, const size_t h,
+              const unsigned fps = 30, const size_t queue_size = 2,
+              const async_writer::full_policy policy = async_writer::full_policy::block);
+
+    // a w x h buffer to render the next frame into, its content is undefined
+    framebuffer &acquire();
+    // hands a buffer obtained from acquire() over to the writer. Returns false once a write failed
+    bool submit(framebuffer &frame);
+
+    // waits for the queued frames to be written, returns false if any write failed
+    bool close();
+
+    async_writer::stats get_stats() const { return mWriter ? mWriter->get_stats() : async_writer::stats(); }
+
+private:
+    bool write_frame(const framebuffer &frame, const size_t index);
+
+    std::string mFilename;
+    FILE *mFile = nullptr;
+    bool mOwnsFile = false;
+    bool mFailed = false;
+    bool mClosed = false;
+    stream_format mFormat = stream_format::ppm;
+    size_t mWidth = 0;
+    size_t mHeight = 0;
+    std::vector<uint8_t> mBuffer; // encoded frame, only touched by the writer thread
+    std::unique_ptr<async_writer> mWriter;
+};
+
+#endif // !FRAME_STREAM_H
@@ -0,0 +1,13 @@
+#include "framebuffer.h"
+
+void framebuffer::resize(const size_t w, const size_t h)
+{
+    const size_t line = framebuffer_alignment / sizeof(uint32_t); // pixels per cache line
+    size_t pitch = (w + line - 1) / line * line;
+    if (pitch * sizeof(uint32_t) % 4096 == 0) pitch += line;
+
+    mWidth = w;
+    mHeight = h;
+    mPitch = pitch;
+    if (mPixels.size() < pitch * h) mPixels.resize(pitch * h);
+}
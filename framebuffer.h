@@ -0,0 +1,86 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+constexpr size_t framebuffer_alignment = 64; // a cache line, and the widest simd store
+
+// std::vector allocator handing out blocks aligned on framebuffer_alignment
+template<typename T> struct aligned_allocator
+{
+    typedef T value_type;
+
+    aligned_allocator() = default;
+    template<typename U> aligned_allocator(const aligned_allocator<U> &) {}
+
+    T *allocate(const size_t n) { return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(framebuffer_alignment))); }
+    void deallocate(T *p, const size_t) { ::operator delete(p, std::align_val_t(framebuffer_alignment)); }
+
+    template<typename U> bool operator==(const aligned_allocator<U> &) const { return true; }
+    template<typename U> bool operator!=(const aligned_allocator<U> &) const { return false; }
+};
+
+// A rectangle of pixels that belong to someone else, usually a framebuffer: pixel (x, y) is at pixels[x + y * pitch].
+// Copying one is free, pass them by value
+class image_view
+{
+public:
+    image_view() = default;
+    image_view(uint32_t *pixels, const size_t w, const size_t h, const size_t pitch)
+        : mPixels(pixels), mWidth(w), mHeight(h), mPitch(pitch) { assert(w <= pitch || h <= 1); }
+
+    size_t width() const { return mWidth; }
+    size_t height() const { return mHeight; }
+    size_t pitch() const { return mPitch; } // pixels from one row to the next
+
+    uint32_t *row(const size_t y) const { assert(y < mHeight); return mPixels + y * mPitch; }
+    uint32_t &at(const size_t x, const size_t y) const { assert(x < mWidth && y < mHeight); return mPixels[x + y * mPitch]; }
+
+    // the part of the rectangle (x, y, w, h) that lies inside this view
+    image_view sub(const size_t x, const size_t y, const size_t w, const size_t h) const
+    {
+        if (x >= mWidth || y >= mHeight) return image_view(mPixels, 0, 0, mPitch);
+        return image_view(mPixels + x + y * mPitch, w < mWidth - x ? w : mWidth - x, h < mHeight - y ? h : mHeight - y, mPitch);
+    }
+
+private:
+    uint32_t *mPixels = nullptr;
+    size_t mWidth = 0;
+    size_t mHeight = 0;
+    size_t mPitch = 0;
+};
+
+// The pixels of a frame. Storage is aligned on a cache line and the pitch is padded to a whole number of cache lines,
+// so every row starts on a line of its own and threads drawing different rows never write to the same line.
+// Rows are never exactly a multiple of 4 KB apart either: a column would then sit in a single set of the cache.
+class framebuffer
+{
+public:
+    framebuffer() = default;
+    framebuffer(const size_t w, const size_t h) { resize(w, h); }
+
+    // the content is undefined afterwards. Memory is only reallocated to grow, resizing to a frame of the same size is free
+    void resize(const size_t w, const size_t h);
+
+    size_t width() const { return mWidth; }
+    size_t height() const { return mHeight; }
+    size_t pitch() const { return mPitch; }
+
+    uint32_t *row(const size_t y) { assert(y < mHeight); return mPixels.data() + y * mPitch; }
+    const uint32_t *row(const size_t y) const { assert(y < mHeight); return mPixels.data() + y * mPitch; }
+
+    image_view view() { return image_view(mPixels.data(), mWidth, mHeight, mPitch); }
+    image_view view(const size_t x, const size_t y, const size_t w, const size_t h) { return view().sub(x, y, w, h); }
+
+private:
+    std::vector<uint32_t, aligned_allocator<uint32_t>> mPixels;
+    size_t mWidth = 0;
+    size_t mHeight = 0;
+    size_t mPitch = 0;
+};
+
+#endif // !FRAMEBUFFER_H
@@ -0,0 +1,59 @@
+#include "game.h"
+#include "image.h"
+
+#include <cstdlib>
+#include <iostream>
+
+std::vector<sprite> game_sprites()
+{
+    return {{3.5f, 4.5f, 0}, {1.8f, 7.4f, 1}, {3.0f, 10.5f, 2}, {5.5f, 12.0f, 3}};
+}
+
+bool load_scene_assets(scene &sc, const bool flat)
+{
+    const size_t ncolors = max_wall_kinds;
+    sc.colors.resize(ncolors);
+    for (size_t i = 0; i < ncolors; i++)
+    {
+        sc.colors[i] = pack_color(rand() % 255, rand() % 255, rand() % 255);
+    }
+
+    // texturing
+    if (!sc.walltext.load("./textures/walltext.png"))
+    {
+        std::cerr << "Faiiled to load wall textures" << std::endl;
+        return false;
+    }
+    if (!sc.spritetext.load("./textures/monsters.png"))
+    {
+        std::cerr << "Failed to load monster textures" << std::endl;
+        return false;
+    }
+    if (!flat)
+    {
+        sc.floor_texture = 5;   // cobblestones
+        sc.ceiling_texture = 1; // grey bricks
+    }
+    return true;
+}
+
+void build_scene_structures(scene &sc, scene_structures &structs, const bool tiled)
+{
+    if (sc.ray_mode == traversal::coarse)
+    {
+        structs.coarse.build(sc.map);
+        sc.coarse = &structs.coarse;
+    }
+    if (sc.ray_mode == traversal::distance_field)
+    {
+        structs.field.build(sc.map);
+        sc.field = &structs.field;
+    }
+    if (tiled)
+    {
+        structs.tiles.build(sc.map);
+        sc.tiles = structs.tiles.view();
+    }
+    structs.entities.build(sc.map.w, sc.map.h, sc.sprites);
+    sc.entities = &structs.entities;
+}
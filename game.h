@@ -0,0 +1,60 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <vector>
+
+#include "coarse_grid.h"
+#include "distance_field.h"
+#include "entity_grid.h"
+#include "map.h"
+#include "render.h"
+#include "sprite.h"
+#include "tiled_map.h"
+
+// What the game and the benchmark share: the built-in map, where the player starts on it, and how a scene is put together
+
+inline constexpr static_map<16, 16> game_map = parse_map<16, 16>("0000222222220000"\
+    "1              0"\
+    "1      11111   0"\
+    "1     0        0"\
+    "0     0  1110000"\
+    "0     3        0"\
+    "0   10000      0"\
+    "0   0   11100  0"\
+    "0   0   0      0"\
+    "0   0   1  00000"\
+    "0       1      0"\
+    "2       1      0"\
+    "0       0      0"\
+    "0 0000000      0"\
+    "0              0"\
+    "0002222222200000"); // our game map
+static_assert(game_map.valid, "map cells are ' ' or '0'..'9'");
+
+constexpr float game_start_x = 3.456f;
+constexpr float game_start_y = 2.345f;
+constexpr float game_start_angle = 1.523f; // angle between the view direction and the x axis
+constexpr float game_view_distance = 20.0f;
+constexpr float game_fov = 1.04719755f;    // pi / 3
+
+// a few monsters around the built-in map
+std::vector<sprite> game_sprites();
+
+// Colors of the map, textures of the walls and the monsters, and unless flat the textures of the floor and the ceiling.
+// Returns false (and says why) if a texture doesn't load
+bool load_scene_assets(scene &sc, const bool flat);
+
+// What a scene points to without owning it, built once for a run
+struct scene_structures
+{
+    coarse_grid coarse;
+    distance_field field;
+    tiled_map tiles;
+    entity_grid entities;
+};
+
+// Builds what sc.ray_mode needs (and the tiled copy of the map if tiled) and the entity grid over sc.sprites into
+// structs, then points sc to them. structs must outlive every use of sc
+void build_scene_structures(scene &sc, scene_structures &structs, const bool tiled);
+
+#endif // !GAME_H
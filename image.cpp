@@ -0,0 +1,198 @@
+#include "image.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <fstream>
+
+#if TFR_X86
+size_t pack_rgb_avx2(const uint32_t *image, const size_t npixels, uint8_t *rgb); // image_avx2.cpp
+void fill_pixels_avx2(uint32_t *dst, const size_t n, const uint32_t color, const bool streaming); // image_avx2.cpp
+void transpose_block_avx2(const uint32_t *src, const size_t src_pitch, uint32_t *dst, const size_t dst_pitch, const size_t w, const size_t h); // image_avx2.cpp
+#endif
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+uint32_t pack_color(const uint8_t r, const uint8_t g, const uint8_t b, const uint8_t a)
+{
+    return (a << 24) + (b << 16) + (g << 8) + r;
+}
+
+void unpack_color(const uint32_t &color, uint8_t &r, uint8_t &g, uint8_t &b, uint8_t &a)
+{
+    r = (color >> 0) & 255;
+    g = (color >> 8) & 255;
+    b = (color >> 16) & 255;
+    a = (color >> 24) & 255;
+}
+
+void pack_rgb(const uint32_t *image, const size_t npixels, uint8_t *rgb)
+{
+    size_t i = 0;
+#if TFR_X86
+    if (get_simd_level() >= simd_level::avx2) i = pack_rgb_avx2(image, npixels, rgb);
+#endif
+    for (; i < npixels; i++)
+    {
+        uint8_t a;
+        unpack_color(image[i], rgb[i * 3 + 0], rgb[i * 3 + 1], rgb[i * 3 + 2], a);
+    }
+}
+
+void encode_ppm(const framebuffer &image, std::vector<uint8_t> &buffer)
+{
+    const size_t w = image.width(), h = image.height();
+    const std::string header = "P6\n" + std::to_string(w) + " " + std::to_string(h) + "\n255\n";
+    buffer.resize(header.size() + w * h * 3); // no reallocation once the buffer has seen a frame this size
+    std::copy(header.begin(), header.end(), buffer.begin());
+    for (size_t j = 0; j < h; j++)
+    {
+        pack_rgb(image.row(j), w, buffer.data() + header.size() + j * w * 3);
+    }
+}
+
+bool create_ppm_image(const std::string filename, const framebuffer &image, std::vector<uint8_t> &buffer)
+{
+    encode_ppm(image, buffer);
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs)
+    {
+        std::cerr << "Error: can not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    ofs.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+    ofs.close();
+    if (!ofs)
+    {
+        std::cerr << "Error: failed to write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool create_ppm_image(const std::string filename, const framebuffer &image)
+{
+    std::vector<uint8_t> buffer;
+    return create_ppm_image(filename, image, buffer);
+}
+
+bool load_texture(const std::string filename, std::vector<uint32_t> &texture, size_t &text_size, size_t &text_count)
+{
+    int nchannels = -1, w, h;
+    unsigned char *pixmap = stbi_load(filename.c_str(), &w, &h, &nchannels, 0);
+    if (!pixmap)
+    {
+        std::cerr << "Error: can not load the textures" << std::endl;
+        return false;
+    }
+
+    if (4 != nchannels)
+    {
+        std::cerr << "Error: the texture must be a 32 bit image" << std::endl;
+        stbi_image_free(pixmap);
+        return false;
+    }
+
+    text_count = w / h;
+    text_size = w / text_count;
+    if (w != h * int(text_count))
+    {
+        std::cerr << "Error: the texture file must contain N square textures packed horizontally" << std::endl;
+        stbi_image_free(pixmap);
+        return false;
+    }
+
+    // the image is row-major with the textures side by side, transpose it: texel (x, y) of the image
+    // belongs to texture x / text_size and lands in column x % text_size of its block
+    texture = std::vector<uint32_t>(w * h);
+    for (int j = 0; j < h; j++)
+    {
+        for (int i = 0; i < w; i++)
+        {
+            uint8_t r = pixmap[(i + j * w) * 4 + 0];
+            uint8_t g = pixmap[(i + j * w) * 4 + 1];
+            uint8_t b = pixmap[(i + j * w) * 4 + 2];
+            uint8_t a = pixmap[(i + j * w) * 4 + 3];
+            texture[i * text_size + j] = pack_color(r, g, b, a);
+        }
+    }
+    stbi_image_free(pixmap);
+    return true;
+}
+
+void fill_pixels(uint32_t *dst, const size_t n, const uint32_t color, const bool streaming)
+{
+#if TFR_X86
+    if (get_simd_level() >= simd_level::avx2)
+    {
+        fill_pixels_avx2(dst, n, color, streaming);
+        return;
+    }
+#endif
+    std::fill_n(dst, n, color);
+}
+
+void clear_image(const image_view img, const uint32_t color, const bool streaming)
+{
+    for (size_t j = 0; j < img.height(); j++)
+    {
+        fill_pixels(img.row(j), img.width(), color, streaming);
+    }
+}
+
+void draw_rectangle(const image_view img, const size_t x, const size_t y, const size_t w, const size_t h, const uint32_t color)
+{
+    // clip once, then every row is a contiguous run
+    const image_view rect = img.sub(x, y, w, h);
+    for (size_t j = 0; j < rect.height(); j++)
+    {
+        std::fill_n(rect.row(j), rect.width(), color);
+    }
+}
+
+void draw_vspan(const image_view img, const size_t x, const size_t y0, const size_t y1, const uint32_t color)
+{
+    if (x >= img.width()) return;
+    const size_t end = std::min(y1, img.height());
+    if (y0 >= end) return;
+    uint32_t *dst = &img.at(x, y0);
+    for (size_t y = y0; y < end; y++, dst += img.pitch())
+    {
+        *dst = color;
+    }
+}
+
+void transpose(const image_view src, const image_view dst)
+{
+    assert(dst.width() == src.height() && dst.height() == src.width());
+    if (src.width() == 0 || src.height() == 0) return;
+#if TFR_X86
+    const bool avx2 = get_simd_level() >= simd_level::avx2;
+#endif
+    for (size_t by = 0; by < src.height(); by += transpose_block)
+    {
+        for (size_t bx = 0; bx < src.width(); bx += transpose_block)
+        {
+            const size_t w = std::min(transpose_block, src.width() - bx);
+            const size_t h = std::min(transpose_block, src.height() - by);
+            const uint32_t *from = src.row(by) + bx;
+            uint32_t *to = dst.row(bx) + by;
+#if TFR_X86
+            if (avx2)
+            {
+                transpose_block_avx2(from, src.pitch(), to, dst.pitch(), w, h);
+                continue;
+            }
+#endif
+            for (size_t j = 0; j < h; j++)
+            {
+                for (size_t i = 0; i < w; i++)
+                {
+                    to[j + i * dst.pitch()] = from[i + j * src.pitch()];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+
+uint32_t pack_color(const uint8_t r, const uint8_t g, const uint8_t b, const uint8_t a = 255);
+void unpack_color(const uint32_t &color, uint8_t &r, uint8_t &g, uint8_t &b, uint8_t &a);
+
+// drops the alpha channel: npixels packed colors become 3 * npixels bytes of r, g, b
+void pack_rgb(const uint32_t *image, const size_t npixels, uint8_t *rgb);
+
+// binary P6 file in memory: header and pixels, ready for a single write. buffer is reused from one call to the next
+void encode_ppm(const framebuffer &image, std::vector<uint8_t> &buffer);
+
+// writes image as a binary P6 file with a single write, returns false (and says why) on I/O errors.
+// Pass the same buffer for every frame to avoid reallocating it.
+bool create_ppm_image(const std::string filename, const framebuffer &image, std::vector<uint8_t> &buffer);
+bool create_ppm_image(const std::string filename, const framebuffer &image);
+// loads text_count square textures packed horizontally in a 32 bit image, and stores each of them in a contiguous
+// block, column-major: texel (x, y) of texture i is at texture[(i * text_size + x) * text_size + y]. See texture_atlas
+bool load_texture(const std::string filename, std::vector<uint32_t> &texture, size_t &text_size, size_t &text_count);
+
+// n pixels of color with the widest stores the cpu has. streaming stores go around the cache (non-temporal): use them
+// for big fills nothing reads back soon, they leave the textures in the cache instead of evicting them
+void fill_pixels(uint32_t *dst, const size_t n, const uint32_t color, const bool streaming = false);
+// the whole view, row by row with fill_pixels()
+void clear_image(const image_view img, const uint32_t color, const bool streaming = false);
+
+// the part of the rectangle inside the image is filled row by row
+void draw_rectangle(const image_view img, const size_t x, const size_t y, const size_t w, const size_t h, const uint32_t color);
+// a 1 pixel wide rectangle: rows [y0, y1) of column x, clipped to the image
+void draw_vspan(const image_view img, const size_t x, const size_t y0, const size_t y1, const uint32_t color);
+
+constexpr size_t transpose_block = 64; // pixels, a block of the source and one of the destination fit in L1 together
+
+// dst(x, y) = src(y, x), dst must be src.height() wide and src.width() tall. Goes through both images in
+// transpose_block square blocks so neither of them thrashes the cache, with 8x8 avx2 kernels within the blocks
+void transpose(const image_view src, const image_view dst);
+
+#endif // !IMAGE_H
@@ -0,0 +1,143 @@
+// AVX2 builds of the image primitives, only called once detect_simd_level() said the cpu can run them
+#include "simd.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if TFR_X86
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+#include <immintrin.h>
+
+// 8 pixels at a time: drop the alpha byte of each pixel within each 128 bit lane, then move the two 12 byte
+// halves next to each other. Every store writes 32 bytes for 24 useful ones, so the loop stops while there is
+// still room for that and the caller finishes the last pixels. Returns how many pixels were packed.
+size_t pack_rgb_avx2(const uint32_t *image, const size_t npixels, uint8_t *rgb)
+{
+    const __m256i drop_alpha = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                                0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+    size_t i = 0;
+    for (; i + 11 <= npixels; i += 8)
+    {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(image + i));
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(px, drop_alpha), compact);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgb + i * 3), packed);
+    }
+    return i;
+}
+
+// up to the first 32 byte boundary one pixel at a time, then whole aligned vectors, then the last pixels. Streaming
+// stores are fenced before returning so whoever reads the pixels next sees them
+void fill_pixels_avx2(uint32_t *dst, const size_t n, const uint32_t color, const bool streaming)
+{
+    size_t i = 0;
+    for (; i < n && (reinterpret_cast<uintptr_t>(dst + i) & 31) != 0; i++) dst[i] = color;
+
+    const __m256i c = _mm256_set1_epi32(int(color));
+    if (streaming)
+    {
+        for (; i + 8 <= n; i += 8) _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i), c);
+        _mm_sfence();
+    }
+    else
+    {
+        for (; i + 8 <= n; i += 8) _mm256_store_si256(reinterpret_cast<__m256i *>(dst + i), c);
+    }
+    for (; i < n; i++) dst[i] = color;
+}
+
+// one block of transpose(): w x h pixels of src land as h x w pixels in dst. 8x8 tiles go through registers,
+// the ragged right and bottom edges of the block are copied one pixel at a time
+void transpose_block_avx2(const uint32_t *src, const size_t src_pitch, uint32_t *dst, const size_t dst_pitch, const size_t w, const size_t h)
+{
+    size_t j = 0;
+    for (; j + 8 <= h; j += 8)
+    {
+        size_t i = 0;
+        for (; i + 8 <= w; i += 8)
+        {
+            const uint32_t *s = src + i + j * src_pitch;
+            __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 0 * src_pitch));
+            __m256i r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 1 * src_pitch));
+            __m256i r2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 2 * src_pitch));
+            __m256i r3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 3 * src_pitch));
+            __m256i r4 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 4 * src_pitch));
+            __m256i r5 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 5 * src_pitch));
+            __m256i r6 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 6 * src_pitch));
+            __m256i r7 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 7 * src_pitch));
+
+            // interleave 32 bit pairs, then 64 bit pairs, then swap the 128 bit halves
+            const __m256i t0 = _mm256_unpacklo_epi32(r0, r1), t1 = _mm256_unpackhi_epi32(r0, r1);
+            const __m256i t2 = _mm256_unpacklo_epi32(r2, r3), t3 = _mm256_unpackhi_epi32(r2, r3);
+            const __m256i t4 = _mm256_unpacklo_epi32(r4, r5), t5 = _mm256_unpackhi_epi32(r4, r5);
+            const __m256i t6 = _mm256_unpacklo_epi32(r6, r7), t7 = _mm256_unpackhi_epi32(r6, r7);
+            const __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+            const __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+            const __m256i u4 = _mm256_unpacklo_epi64(t4, t6), u5 = _mm256_unpackhi_epi64(t4, t6);
+            const __m256i u6 = _mm256_unpacklo_epi64(t5, t7), u7 = _mm256_unpackhi_epi64(t5, t7);
+            r0 = _mm256_permute2x128_si256(u0, u4, 0x20);
+            r1 = _mm256_permute2x128_si256(u1, u5, 0x20);
+            r2 = _mm256_permute2x128_si256(u2, u6, 0x20);
+            r3 = _mm256_permute2x128_si256(u3, u7, 0x20);
+            r4 = _mm256_permute2x128_si256(u0, u4, 0x31);
+            r5 = _mm256_permute2x128_si256(u1, u5, 0x31);
+            r6 = _mm256_permute2x128_si256(u2, u6, 0x31);
+            r7 = _mm256_permute2x128_si256(u3, u7, 0x31);
+
+            uint32_t *d = dst + j + i * dst_pitch;
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 0 * dst_pitch), r0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 1 * dst_pitch), r1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 2 * dst_pitch), r2);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 3 * dst_pitch), r3);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 4 * dst_pitch), r4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 5 * dst_pitch), r5);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 6 * dst_pitch), r6);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 7 * dst_pitch), r7);
+        }
+        for (; i < w; i++)
+        {
+            for (size_t k = j; k < j + 8; k++) dst[k + i * dst_pitch] = src[i + k * src_pitch];
+        }
+    }
+    for (; j < h; j++)
+    {
+        for (size_t i = 0; i < w; i++) dst[j + i * dst_pitch] = src[i + j * src_pitch];
+    }
+}
+
+// 8 texels of a floor span at a time: the 16.16 coordinates of 8 pixels in a row are a single add away from the
+// previous 8, their integer parts wrap to the texture and become indices of a gather. Returns how many pixels were
+// filled, the caller finishes the last ones
+size_t fill_span_avx2(uint32_t *dst, const size_t n, const uint32_t *texels, const uint32_t shift,
+                      const uint32_t u, const uint32_t v, const uint32_t du, const uint32_t dv)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i mask = _mm256_set1_epi32(int((1u << shift) - 1));
+    const __m128i sh = _mm_cvtsi32_si128(int(shift));
+    __m256i vu = _mm256_add_epi32(_mm256_set1_epi32(int(u)), _mm256_mullo_epi32(lane, _mm256_set1_epi32(int(du))));
+    __m256i vv = _mm256_add_epi32(_mm256_set1_epi32(int(v)), _mm256_mullo_epi32(lane, _mm256_set1_epi32(int(dv))));
+    const __m256i step_u = _mm256_set1_epi32(int(du * 8));
+    const __m256i step_v = _mm256_set1_epi32(int(dv * 8));
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i tx = _mm256_and_si256(_mm256_srli_epi32(vu, 16), mask);
+        const __m256i ty = _mm256_and_si256(_mm256_srli_epi32(vv, 16), mask);
+        const __m256i idx = _mm256_or_si256(_mm256_sll_epi32(tx, sh), ty);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_i32gather_epi32(reinterpret_cast<const int *>(texels), idx, 4));
+        vu = _mm256_add_epi32(vu, step_u);
+        vv = _mm256_add_epi32(vv, step_v);
+    }
+    return i;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+#endif
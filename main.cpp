@@ -3,9 +3,18 @@
 #include <fstream>
 #include <cstdint>
 #include <vector>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include <string>
+#include <cstdlib>
+
+#include "framebuffer.h"
+#include "image.h"
+#include "game.h"
+#include "map.h"
+#include "map_file.h"
+#include "raycast.h"
+#include "camera.h"
+#include "render.h"
+#include "frame_stream.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -17,203 +26,111 @@ functions: func_name()
 class names: class_name
 */
 
-uint32_t pack_color(const uint8_t r, const uint8_t g, const uint8_t b, const uint8_t a = 255)
-{
-    return (a << 24) + (b << 16) + (g << 8) + r;
-}
-
-void unpack_color(const uint32_t &color, uint8_t &r, uint8_t &g, uint8_t &b, uint8_t &a)
-{
-    r = (color >> 0) & 255;
-    g = (color >> 8) & 255;
-    b = (color >> 16) & 255;
-    a = (color >> 24) & 255;
-}
-
-void create_ppm_image(const std::string filename, const std::vector<uint32_t> &image, const size_t w, const size_t h)
-{
-    assert(image.size() == w * h);
-    std::ofstream ofs(filename);
-    ofs << "P6\n" << w << " " << h << "\n255\n";
-    for (size_t i = 0; i < h * w; ++i)
-    {
-        uint8_t r, g, b, a;
-        unpack_color(image[i], r, g, b, a);
-        ofs << static_cast<char>(r) << static_cast<char>(g) << static_cast<char>(b);
-    }
-    ofs.close();
-}
-
-bool load_texture(const std::string filename, std::vector<uint32_t> &texture, size_t &text_size, size_t &text_count)
-{
-    int nchannels = -1, w, h;
-    unsigned char *pixmap = stbi_load(filename.c_str(), &w, &h, &nchannels, 0);
-    if (!pixmap)
-    {
-        std::cerr << "Error: can not load the textures" << std::endl;
-        return false;
-    }
-
-    if (4 != nchannels)
-    {
-        std::cerr << "Error: the texture must be a 32 bit image" << std::endl;
-        stbi_image_free(pixmap);
-        return false;
-    }
-
-    text_count = w / h;
-    text_size = w / text_count;
-    if (w != h * int(text_count))
-    {
-        std::cerr << "Error: the texture file must contain N square textures packed horizontally" << std::endl;
-        stbi_image_free(pixmap);
-        return false;
-    }
-
-    texture = std::vector<uint32_t>(w * h);
-    for (int j = 0; j < h; j++)
-    {
-        for (int i = 0; i < w; i++)
-        {
-            uint8_t r = pixmap[(i + j * w) * 4 + 0];
-            uint8_t g = pixmap[(i + j * w) * 4 + 1];
-            uint8_t b = pixmap[(i + j * w) * 4 + 2];
-            uint8_t a = pixmap[(i + j * w) * 4 + 3];
-            texture[i + j * w] = pack_color(r, g, b, a);
-        }
-    }
-    stbi_image_free(pixmap);
-    return true;
-}
-
-void draw_rectangle(std::vector<uint32_t> &img, const size_t img_w, const size_t img_h, const size_t x, const size_t y, const size_t w, const size_t h, const uint32_t color)
+int main(int argc, char **argv)
 {
-    assert(img.size() == img_w * img_h);
-    for (size_t i = 0; i < w; i++)
+    column_layout layout = column_layout::row_major;
+    size_t nthreads = 0; // 0: one render thread per core
+    size_t nframes = 0;  // 0: a single frame to ./out.ppm, otherwise an animation streamed to output
+    stream_format format = stream_format::ppm;
+    std::string output = "-";
+    size_t queue_size = 2; // frames waiting for the writer before the renderer has to wait
+    async_writer::full_policy policy = async_writer::full_policy::block;
+    std::string map_filename;  // empty: the built-in map
+    std::string save_map_filename; // converts the map to a binary map file instead of rendering
+    traversal ray_mode = traversal::dda;
+    bool tiled = false; // a copy of the map in tiles for the dda
+    bool flat = false;  // plain colors for the floor and the ceiling instead of textures
+    for (int i = 1; i < argc; i++)
     {
-        for (size_t j = 0; j < h; j++)
+        const std::string arg = argv[i];
+        if (arg == "--column-major") layout = column_layout::column_major;
+        else if (arg == "--traversal" && i + 1 < argc && traversal_from_name(argv[i + 1], ray_mode)) i++;
+        else if (arg == "--tiled") tiled = true;
+        else if (arg == "--flat") flat = true;
+        else if (arg == "--threads" && i + 1 < argc) nthreads = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--frames" && i + 1 < argc) nframes = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--format" && i + 1 < argc && std::string(argv[i + 1]) == "ppm") { format = stream_format::ppm; i++; }
+        else if (arg == "--format" && i + 1 < argc && std::string(argv[i + 1]) == "y4m") { format = stream_format::y4m; i++; }
+        else if (arg == "--format" && i + 1 < argc && std::string(argv[i + 1]) == "ppm-files") { format = stream_format::ppm_files; i++; }
+        else if (arg == "--output" && i + 1 < argc) output = argv[++i];
+        else if (arg == "--queue" && i + 1 < argc) queue_size = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--drop") policy = async_writer::full_policy::drop_oldest;
+        else if (arg == "--map" && i + 1 < argc) map_filename = argv[++i];
+        else if (arg == "--save-map" && i + 1 < argc) save_map_filename = argv[++i];
+        else
         {
-            size_t cx = x + i;
-            size_t cy = y + j;
-            if (cx >= img_w || cy >= img_h) continue; // no need to check negative values (unsigned )
-            img[cx + cy * img_w] = color;
+            std::cerr << "Usage: " << argv[0] << " [--map FILE] [--save-map FILE] [--threads N] [--column-major] [--traversal march|dda|coarse|distance-field] [--tiled] [--flat] [--frames N [--format ppm|y4m|ppm-files] [--output FILE|-] [--queue N] [--drop]]" << std::endl;
+            return -1;
         }
     }
-}
 
-int main()
-{
     const size_t win_w = 1024;
     const size_t win_h = 512;
-    std::vector<uint32_t> framebuffer(win_w * win_h, pack_color(255, 255, 255));
-
-    const size_t map_w = 16;
-    const size_t map_h = 16;
-    const char map[] = "0000222222220000"\
-        "1              0"\
-        "1      11111   0"\
-        "1     0        0"\
-        "0     0  1110000"\
-        "0     3        0"\
-        "0   10000      0"\
-        "0   0   11100  0"\
-        "0   0   0      0"\
-        "0   0   1  00000"\
-        "0       1      0"\
-        "2       1      0"\
-        "0       0      0"\
-        "0 0000000      0"\
-        "0              0"\
-        "0002222222200000"; // our game map
-    assert(sizeof(map) == map_w * map_h + 1);
 
     // Player
-    float player_x = 3.456f;
-    float player_y = 2.345f;
-    float player_view_angle = 1.523f; // angle between the view direction and the x axis
-    const float player_view_distance = 20.0f;
-    const float fov = M_PI / 3;
-
-    const size_t ncolors = 10;
-    std::vector<uint32_t> colors(ncolors);
-    for (size_t i = 0; i < ncolors; i++)
+    float player_x = game_start_x;
+    float player_y = game_start_y;
+    const float player_view_angle = game_start_angle;
+    const float player_view_distance = game_view_distance;
+    const float fov = game_fov;
+
+    scene sc;
+    sc.map = game_map.view();
+    map_file file;
+    if (!map_filename.empty())
     {
-        colors[i] = pack_color(rand() % 255, rand() % 255, rand() % 255);
+        if (!file.load(map_filename)) return -1;
+        sc.map = file.view();
+        if (file.has_start())
+        {
+            player_x = file.start_x() + 0.5f;
+            player_y = file.start_y() + 0.5f;
+        }
     }
-
-    // texturing
-    std::vector<uint32_t> walltext; // textures of walls
-    size_t walltext_size;
-    size_t walltext_count;
-    if (!load_texture("./textures/walltext.png", walltext, walltext_size, walltext_count))
+    if (!save_map_filename.empty())
     {
-        std::cerr << "Faiiled to load wall textures" << std::endl;
-        return -1;
+        const bool has_start = map_filename.empty() || file.has_start();
+        return map_file::save_binary(save_map_filename, sc.map, has_start ? size_t(player_x) : SIZE_MAX, has_start ? size_t(player_y) : SIZE_MAX) ? 0 : -1;
     }
 
-    const size_t rect_w = win_w / (map_w * 2); // Left side of screen is map, right side is 3d projection
-    const size_t rect_h = win_h / map_h;
+    if (!load_scene_assets(sc, flat)) return -1;
+    if (map_filename.empty()) sc.sprites = game_sprites();
 
-    // basic animation to showcase raycasting
+    // what the traversal needs, built once for the whole run
+    sc.ray_mode = ray_mode;
+    scene_structures structs;
+    build_scene_structures(sc, structs, tiled);
 
-    for (size_t j = 0; j < map_h; j++)
-    { // draw the map
-        for (size_t i = 0; i < map_w; i++)
+    renderer rend(nthreads, layout);
+    if (nframes == 0)
+    {
+        framebuffer fb(win_w, win_h);
+        rend.render_frame(fb, sc, make_camera(player_x, player_y, player_view_angle, fov), player_view_distance);
+        if (!create_ppm_image("./out.ppm", fb))
         {
-            if (map[i + j * map_w] == ' ') continue; // skip empty spaces
-            size_t rect_x = i * rect_w;
-            size_t rect_y = j * rect_h;
-            size_t icolor = map[i + j * map_w] - '0';
-            assert(icolor < ncolors);
-            draw_rectangle(framebuffer, win_w, win_h, rect_x, rect_y, rect_w, rect_h, colors[icolor]);
+            return -1;
         }
+        return 0;
     }
 
-    // draw player view direction with fov
-    for (size_t i = 0; i < win_w / 2; i++) //loops through 0->512, casting 512 rays
+    // basic animation to showcase raycasting: the player turns around once over the sequence.
+    // Frames are written on a background thread while the next ones render
+    frame_stream stream;
+    if (!stream.open(output, format, win_w, win_h, 30, queue_size, policy))
     {
-        float angle = player_view_angle - fov / 2 + fov * i / float(win_w / 2);
-        for (float t = 0; t < player_view_distance; t += 0.01f)
-        {
-            // t is effectively the distance from (cx, cy) to (player_x, player_y)
-            float cx = player_x + t * cosf(angle);
-            float cy = player_y + t * sinf(angle);
-            // (cx, cy) is the hit point
-
-            size_t pix_x = cx * rect_w;
-            size_t pix_y = cy * rect_h;
-            framebuffer[pix_x + pix_y * win_w] = pack_color(160, 160, 160); // this draws the visibility cone
-
-            // our ray touches a wall, so draw the vertical column to create an illusion of 3d
-            if (map[int(cx) + int(cy) * map_w] != ' ')
-            {
-                size_t icolor = map[int(cx) + int(cy) * map_w] - '0';
-                assert(icolor < ncolors);
-                // height of the wall: inversely proportional to the distance to the nearest obstacle
-                // think of the effect when you see things far away they appear "small" vs things closer to you.
-                size_t column_height = win_h / (t * cosf(angle - player_view_angle)); // denominator deals with fish eye distortion
-                draw_rectangle(framebuffer,
-                               win_w,                           // img_w
-                               win_h,                           // img_h
-                               win_w / 2 + i,                   // x
-                               win_h / 2 - column_height / 2,   // y
-                               1,                               // width
-                               column_height,                   // height
-                               colors[icolor]);                 // color
-                break;
-            }
-        }
+        return -1;
     }
-
-    const size_t text_id = 4; // draw the ith texture on the screen
-    for(size_t i = 0; i < walltext_size; i++)
+    for (size_t frame = 0; frame < nframes; frame++)
     {
-        for(size_t j = 0; j < walltext_size; j++)
-        {
-            framebuffer[i+j*win_w] = walltext[i + text_id*walltext_size + j * walltext_size * walltext_count];
-        }
+        const float angle = player_view_angle + 2 * M_PI * frame / nframes;
+        framebuffer &fb = stream.acquire();
+        rend.render_frame(fb, sc, make_camera(player_x, player_y, angle, fov), player_view_distance);
+        if (!stream.submit(fb)) break;
     }
-    create_ppm_image("./out.ppm", framebuffer, win_w, win_h);
+    const bool ok = stream.close();
 
-    return 0;
-}
\ No newline at end of file
+    const async_writer::stats stats = stream.get_stats();
+    std::cerr << stats.written << "/" << stats.submitted << " frames written, " << stats.dropped << " dropped, "
+              << stats.blocked << " times the renderer waited for the writer, queue depth up to " << stats.max_depth << std::endl;
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,140 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// A map cell holds the kind of wall in it, which is also the texture and the map color of the wall, or empty_cell.
+// Maps are written as text, ' ' for an empty cell and '0'..'9' for walls, and parsed once into cells
+constexpr uint8_t empty_cell = 255;
+constexpr size_t max_wall_kinds = 10;
+
+// the kind of wall a hit cell is drawn as. Binary maps are used as they are in the file, unchecked: whatever else a
+// damaged one holds, empty_cell under a set occupancy bit included, draws as the last kind rather than indexing past
+// the colors and textures of the walls
+constexpr uint8_t wall_kind(const uint8_t cell) { return cell < max_wall_kinds ? cell : uint8_t(max_wall_kinds - 1); }
+
+constexpr size_t occupancy_words(const size_t ncells) { return (ncells + 63) / 64; } // words of bits for a row of cells
+
+// What everything reading a map takes: w * h cells, row-major, owned by someone else (a static_map, a map_file...).
+// Next to the cells, the owner keeps one occupancy bit per cell, set for walls, twice: once by rows and once by
+// columns. Ray traversal only needs to know wall or empty on most steps, the bits answer that with an eighth of the
+// memory traffic of the cells, and a whole run of cells along a row (or a column) is checked by scanning words.
+// Cheap to copy, no bounds checks
+struct map_view
+{
+    const uint8_t *cells = nullptr;
+    const uint64_t *rows = nullptr; // bit x % 64 of rows[y * row_words + x / 64] is set when (x, y) is a wall
+    const uint64_t *cols = nullptr; // bit y % 64 of cols[x * col_words + y / 64] is set when (x, y) is a wall
+    size_t w = 0;
+    size_t h = 0;
+    size_t row_words = 0; // occupancy_words(w)
+    size_t col_words = 0; // occupancy_words(h)
+
+    uint8_t at(const size_t x, const size_t y) const { return cells[x + y * w]; }
+    bool wall(const size_t x, const size_t y) const { return (rows[y * row_words + x / 64] >> (x % 64)) & 1; }
+};
+
+// rows needs h * occupancy_words(w) words and cols w * occupancy_words(h), all of them zero
+constexpr void set_occupancy(const uint8_t *cells, const size_t w, const size_t h, uint64_t *rows, uint64_t *cols)
+{
+    for (size_t y = 0; y < h; y++)
+    {
+        for (size_t x = 0; x < w; x++)
+        {
+            if (cells[x + y * w] == empty_cell) continue;
+            rows[y * occupancy_words(w) + x / 64] |= uint64_t(1) << (x % 64);
+            cols[x * occupancy_words(h) + y / 64] |= uint64_t(1) << (y % 64);
+        }
+    }
+}
+
+constexpr map_view make_map_view(const uint8_t *cells, const size_t w, const size_t h, const uint64_t *rows, const uint64_t *cols)
+{
+    return map_view{cells, rows, cols, w, h, occupancy_words(w), occupancy_words(h)};
+}
+
+// A map built at run time, from a file or generated. Owns its cells and keeps their occupancy bits in sync
+class map_grid
+{
+public:
+    map_grid() = default;
+    map_grid(const size_t w, const size_t h) { assign(w, h); }
+
+    // w x h empty cells
+    void assign(const size_t w, const size_t h)
+    {
+        mW = w;
+        mH = h;
+        mCells.assign(w * h, empty_cell);
+        mRows.assign(h * occupancy_words(w), 0);
+        mCols.assign(w * occupancy_words(h), 0);
+    }
+
+    // w * h cells, row-major
+    void assign(std::vector<uint8_t> cells, const size_t w, const size_t h)
+    {
+        mW = w;
+        mH = h;
+        mCells = std::move(cells);
+        mRows.assign(h * occupancy_words(w), 0);
+        mCols.assign(w * occupancy_words(h), 0);
+        set_occupancy(mCells.data(), w, h, mRows.data(), mCols.data());
+    }
+
+    void set(const size_t x, const size_t y, const uint8_t cell)
+    {
+        mCells[x + y * mW] = cell;
+        const uint64_t row_bit = uint64_t(1) << (x % 64), col_bit = uint64_t(1) << (y % 64);
+        uint64_t &row = mRows[y * occupancy_words(mW) + x / 64];
+        uint64_t &col = mCols[x * occupancy_words(mH) + y / 64];
+        row = cell == empty_cell ? row & ~row_bit : row | row_bit;
+        col = cell == empty_cell ? col & ~col_bit : col | col_bit;
+    }
+
+    map_view view() const { return make_map_view(mCells.data(), mW, mH, mRows.data(), mCols.data()); }
+
+private:
+    std::vector<uint8_t> mCells;
+    std::vector<uint64_t> mRows;
+    std::vector<uint64_t> mCols;
+    size_t mW = 0;
+    size_t mH = 0;
+};
+
+// the cell a map character stands for, invalid characters give max_wall_kinds
+constexpr uint8_t parse_cell(const char c)
+{
+    return c == ' ' ? empty_cell : c >= '0' && c < char('0' + max_wall_kinds) ? uint8_t(c - '0') : uint8_t(max_wall_kinds);
+}
+
+// A map parsed at compile time from a string literal, see parse_map()
+template<size_t W, size_t H> struct static_map
+{
+    uint8_t cells[W * H] = {};
+    uint64_t rows[H * occupancy_words(W)] = {};
+    uint64_t cols[W * occupancy_words(H)] = {};
+    bool valid = false; // every character was a cell
+
+    constexpr map_view view() const { return make_map_view(cells, W, H, rows, cols); }
+};
+
+// constexpr auto m = parse_map<16, 16>("0000..."); static_assert(m.valid, "...");
+// The size of the text is checked here, the characters by static_assert(m.valid) at the call site
+template<size_t W, size_t H, size_t N> constexpr static_map<W, H> parse_map(const char (&text)[N])
+{
+    static_assert(N == W * H + 1, "the map text must have exactly W * H cells");
+    static_map<W, H> res;
+    res.valid = true;
+    for (size_t i = 0; i < W * H; i++)
+    {
+        res.cells[i] = parse_cell(text[i]);
+        if (res.cells[i] == max_wall_kinds) res.valid = false;
+    }
+    set_occupancy(res.cells, W, H, res.rows, res.cols);
+    return res;
+}
+
+#endif // !MAP_H
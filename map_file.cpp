@@ -0,0 +1,242 @@
+#include "map_file.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // start of binary map files, all fields little endian. The cells follow right after it, w * h bytes
+    struct binary_header
+    {
+        char magic[8];
+        uint32_t w;
+        uint32_t h;
+        uint32_t start_x;
+        uint32_t start_y;
+        uint32_t occupancy; // offset of the occupancy bits in the file, rows then columns. 0: none, they get built
+        uint32_t reserved;
+    };
+    static_assert(sizeof(binary_header) == 32, "the binary map header is 32 bytes");
+
+    const char binary_magic[8] = {'T', 'F', 'R', 'M', 'A', 'P', '0', '1'};
+}
+
+bool map_file::load(const std::string filename)
+{
+    close();
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs)
+    {
+        std::cerr << "Error: can not open " << filename << std::endl;
+        return false;
+    }
+    char magic[sizeof(binary_magic)] = {};
+    ifs.read(magic, sizeof(magic));
+    ifs.close();
+    return memcmp(magic, binary_magic, sizeof(magic)) == 0 ? load_binary(filename) : load_text(filename);
+}
+
+bool map_file::load_text(const std::string &filename)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    std::stringstream text;
+    text << ifs.rdbuf();
+
+    std::string line;
+    std::vector<uint8_t> cells;
+    size_t w = 0, h = 0;
+    while (std::getline(text, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) break; // a blank line ends the map
+        if (h == 0) w = line.size();
+        if (line.size() != w)
+        {
+            std::cerr << "Error: line " << h + 1 << " of " << filename << " is " << line.size() << " cells long instead of " << w << std::endl;
+            return false;
+        }
+        if ((h + 1) * w > max_map_cells)
+        {
+            std::cerr << "Error: " << filename << " has more than " << max_map_cells << " cells" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < w; i++)
+        {
+            if (line[i] == '@')
+            {
+                if (mStartX != SIZE_MAX)
+                {
+                    std::cerr << "Error: second start '@' line " << h + 1 << " of " << filename << ", the first one is line " << mStartY + 1 << std::endl;
+                    return false;
+                }
+                mStartX = i;
+                mStartY = h;
+                cells.push_back(empty_cell);
+                continue;
+            }
+            const uint8_t cell = parse_cell(line[i]);
+            if (cell == max_wall_kinds)
+            {
+                std::cerr << "Error: invalid cell '" << line[i] << "' line " << h + 1 << " of " << filename << std::endl;
+                return false;
+            }
+            cells.push_back(cell);
+        }
+        h++;
+    }
+    if (w == 0 || h == 0)
+    {
+        std::cerr << "Error: " << filename << " is empty" << std::endl;
+        return false;
+    }
+
+    mGrid.assign(std::move(cells), w, h);
+    mView = mGrid.view();
+    return true;
+}
+
+bool map_file::load_binary(const std::string &filename)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Error: can not open " << filename << std::endl;
+        return false;
+    }
+    mFile = file;
+    LARGE_INTEGER size;
+    HANDLE mapping = GetFileSizeEx(file, &size) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    if (!mapping)
+    {
+        std::cerr << "Error: can not map " << filename << std::endl;
+        close();
+        return false;
+    }
+    mMapping = mapping;
+    mMapped = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    mMappedSize = size_t(size.QuadPart);
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Error: can not open " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    void *mapped = fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd); // the mapping keeps the file alive
+    mMapped = mapped != MAP_FAILED ? static_cast<const uint8_t *>(mapped) : nullptr;
+    mMappedSize = mMapped ? size_t(st.st_size) : 0;
+#endif
+    if (!mMapped)
+    {
+        std::cerr << "Error: can not map " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    binary_header header;
+    if (mMappedSize < sizeof(header))
+    {
+        std::cerr << "Error: " << filename << " is too short to be a map" << std::endl;
+        close();
+        return false;
+    }
+    memcpy(&header, mMapped, sizeof(header));
+    const size_t w = header.w, h = header.h;
+    const size_t ncells = w * h;
+    const size_t nwords = h * occupancy_words(w) + w * occupancy_words(h);
+    const size_t occupancy_end = header.occupancy + nwords * sizeof(uint64_t);
+    if (w == 0 || h == 0 || ncells > max_map_cells ||
+        (header.occupancy == 0 && mMappedSize != sizeof(header) + ncells) ||
+        (header.occupancy != 0 && (header.occupancy % 8 != 0 || header.occupancy < sizeof(header) + ncells || mMappedSize != occupancy_end)))
+    {
+        std::cerr << "Error: the header of " << filename << " doesn't match its size" << std::endl;
+        close();
+        return false;
+    }
+
+    const size_t start_x = header.start_x, start_y = header.start_y;
+    const uint8_t *cells = mMapped + sizeof(header);
+    if (header.occupancy == 0)
+    { // no bits in the file, they have to be built from a copy of the cells
+        std::vector<uint8_t> copy(cells, cells + ncells);
+        close();
+        mGrid.assign(std::move(copy), w, h);
+        mView = mGrid.view();
+    }
+    else
+    { // the cells and their bits are used right where they are
+        const uint64_t *rows = reinterpret_cast<const uint64_t *>(mMapped + header.occupancy);
+        mView = make_map_view(cells, w, h, rows, rows + h * occupancy_words(w));
+    }
+    mStartX = start_x;
+    mStartY = start_y;
+    return true;
+}
+
+bool map_file::save_binary(const std::string filename, const map_view &map, const size_t start_x, const size_t start_y)
+{
+    binary_header header = {};
+    memcpy(header.magic, binary_magic, sizeof(binary_magic));
+    header.w = uint32_t(map.w);
+    header.h = uint32_t(map.h);
+    header.start_x = start_x < map.w ? uint32_t(start_x) : UINT32_MAX;
+    header.start_y = start_y < map.h ? uint32_t(start_y) : UINT32_MAX;
+    const size_t ncells = map.w * map.h;
+    const size_t padding = (8 - (sizeof(header) + ncells) % 8) % 8; // the bits are read in place, as 64 bit words
+    header.occupancy = uint32_t(sizeof(header) + ncells + padding);
+    const char zeros[8] = {};
+
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs)
+    {
+        std::cerr << "Error: can not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char *>(map.cells), ncells);
+    ofs.write(zeros, padding);
+    ofs.write(reinterpret_cast<const char *>(map.rows), map.h * map.row_words * sizeof(uint64_t));
+    ofs.write(reinterpret_cast<const char *>(map.cols), map.w * map.col_words * sizeof(uint64_t));
+    ofs.close();
+    if (!ofs)
+    {
+        std::cerr << "Error: failed to write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void map_file::close()
+{
+#ifdef _WIN32
+    if (mMapped) UnmapViewOfFile(mMapped);
+    if (mMapping) CloseHandle(mMapping);
+    if (mFile) CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    if (mMapped) munmap(const_cast<uint8_t *>(mMapped), mMappedSize);
+#endif
+    mMapped = nullptr;
+    mMappedSize = 0;
+    mGrid = map_grid();
+    mView = map_view();
+    mStartX = SIZE_MAX;
+    mStartY = SIZE_MAX;
+}
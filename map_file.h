@@ -0,0 +1,60 @@
+#ifndef MAP_FILE_H
+#define MAP_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "map.h"
+
+constexpr size_t max_map_cells = size_t(1) << 30; // cell indices have to fit in the 32 bit lanes of the packet kernels
+
+// A map loaded from a file, in either of two formats:
+//  - text, for authoring: one line per row of the map, all of the same length. ' ' is an empty cell,
+//    '0'..'9' are walls and '@' is an empty cell where the player starts.
+//  - binary, for playing: a 32 byte header (see map_file.cpp) followed by the cells and their occupancy bits exactly
+//    as map_view wants them. The file is memory mapped and used in place: loading reads the header and nothing
+//    else, pages are read as the rays reach them. Neither the cells nor the bits are checked, binary maps are written
+//    by save_binary() from valid maps. A damaged one draws wrong but safely: any cell value draws as some wall kind
+//    (see wall_kind()).
+// load() tells the two apart by the magic number at the start of binary files.
+class map_file
+{
+public:
+    map_file() = default;
+    ~map_file() { close(); }
+    map_file(const map_file &) = delete;
+    map_file &operator=(const map_file &) = delete;
+
+    // returns false (and says why) if the file can't be read or isn't a valid map
+    bool load(const std::string filename);
+    // writes map and its occupancy bits as a binary map file, start_x and start_y are the cell where the player starts
+    static bool save_binary(const std::string filename, const map_view &map, const size_t start_x, const size_t start_y);
+
+    map_view view() const { return mView; }
+    bool binary() const { return mMapped != nullptr; } // mapped rather than parsed
+
+    // the cell the player starts in, if the map says so
+    bool has_start() const { return mStartX < mView.w && mStartY < mView.h; }
+    size_t start_x() const { return mStartX; }
+    size_t start_y() const { return mStartY; }
+
+private:
+    bool load_text(const std::string &filename);
+    bool load_binary(const std::string &filename);
+    void close();
+
+    map_grid mGrid; // parsed text maps
+    const uint8_t *mMapped = nullptr; // mapped binary maps
+    size_t mMappedSize = 0;
+#ifdef _WIN32
+    void *mFile = nullptr; // HANDLEs of the file and of its mapping
+    void *mMapping = nullptr;
+#endif
+    map_view mView;
+    size_t mStartX = SIZE_MAX;
+    size_t mStartY = SIZE_MAX;
+};
+
+#endif // !MAP_FILE_H
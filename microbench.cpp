@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+#include "image.h"
+#include "simd.h"
+#include "texture.h"
+
+// Microbenchmarks of the image primitives, one line each: time per call and bytes per second.
+// Self-contained on purpose, no benchmark library to fetch: microbench [--min-time SECONDS] [FILTER]
+// runs the benchmarks whose name contains FILTER, every one of them without it
+
+namespace
+{
+    double min_seconds = 0.25;
+    std::string filter;
+
+    // written with every result, so the compiler can't drop the work that led to it
+    volatile uint32_t sink = 0;
+
+    // runs func until at least min_seconds went by, then prints the time of one call and bytes / time.
+    // bytes is what one call produces (or reads, for the ones producing nothing)
+    template<typename F> void run(const std::string &name, const double bytes, F func)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos) return;
+        using clock = std::chrono::steady_clock;
+        func(); // warm-up: first touch of the buffers, lazy initializations
+        size_t iterations = 0;
+        const auto start = clock::now();
+        double elapsed = 0.0;
+        do
+        {
+            func();
+            iterations++;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while (elapsed < min_seconds);
+        const double t = elapsed / iterations;
+
+        char line[160];
+        snprintf(line, sizeof(line), "%-44s %12.1f ns %10zu iterations %10.3f GB/s", name.c_str(), t * 1e9, iterations, bytes / t / 1e9);
+        std::cout << line << std::endl;
+    }
+
+    void bench_pack_unpack(const size_t n)
+    {
+        std::vector<uint8_t> r(n), g(n), b(n), a(n);
+        std::vector<uint32_t> packed(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            r[i] = uint8_t(i);
+            g[i] = uint8_t(i >> 8);
+            b[i] = uint8_t(i * 7);
+            a[i] = uint8_t(255 - i);
+        }
+        const std::string size = "/" + std::to_string(n);
+        run("pack_color" + size, 4.0 * n, [&]()
+        {
+            for (size_t i = 0; i < n; i++) packed[i] = pack_color(r[i], g[i], b[i], a[i]);
+            sink = packed[n / 2];
+        });
+        run("unpack_color" + size, 4.0 * n, [&]()
+        {
+            for (size_t i = 0; i < n; i++) unpack_color(packed[i], r[i], g[i], b[i], a[i]);
+            sink = r[n / 2] + a[n - 1];
+        });
+        std::vector<uint8_t> rgb(3 * n);
+        run("pack_rgb" + size, 4.0 * n, [&]()
+        {
+            pack_rgb(packed.data(), n, rgb.data());
+            sink = rgb[n];
+        });
+    }
+
+    void bench_draw_rectangle()
+    {
+        framebuffer fb(1024, 1024);
+        // squares, then the same area or less in wide and tall shapes: rows of contiguous stores against one
+        // store per row
+        const size_t sizes[][2] = {{1, 1}, {8, 8}, {64, 64}, {512, 512}, {1024, 1024},
+                                   {1024, 4}, {4, 1024}, {1024, 1}, {1, 1024}, {256, 16}, {16, 256}};
+        for (const auto &size : sizes)
+        {
+            const size_t w = size[0], h = size[1];
+            uint32_t color = 0;
+            run("draw_rectangle/" + std::to_string(w) + "x" + std::to_string(h), 4.0 * w * h, [&]()
+            {
+                draw_rectangle(fb.view(), 0, 0, w, h, color++);
+                sink = fb.row(h - 1)[w - 1];
+            });
+        }
+    }
+
+    void bench_load_texture(const std::string &filename)
+    {
+        std::vector<uint32_t> texels;
+        size_t text_size = 0, text_count = 0;
+        if (!load_texture(filename, texels, text_size, text_count))
+        {
+            std::cerr << "skipping load_texture on " << filename << std::endl;
+            return;
+        }
+        // decoding the png and repacking it column-major, then the same with the mip levels on top
+        const std::string name = filename.substr(filename.find_last_of('/') + 1);
+        run("load_texture/" + name, 4.0 * texels.size(), [&]()
+        {
+            load_texture(filename, texels, text_size, text_count);
+            sink = texels[0];
+        });
+        texture_atlas atlas;
+        run("texture_atlas::load/" + name, 4.0 * texels.size(), [&]()
+        {
+            atlas.load(filename);
+            sink = atlas.texel(0, 0, 0);
+        });
+    }
+
+    void bench_ppm(const size_t w, const size_t h)
+    {
+        framebuffer fb(w, h);
+        for (size_t j = 0; j < h; j++)
+        {
+            for (size_t i = 0; i < w; i++) fb.row(j)[i] = pack_color(uint8_t(i), uint8_t(j), uint8_t(i + j));
+        }
+        std::vector<uint8_t> buffer;
+        encode_ppm(fb, buffer);
+        const double bytes = double(buffer.size());
+        const std::string size = "/" + std::to_string(w) + "x" + std::to_string(h);
+        run("encode_ppm" + size, bytes, [&]()
+        {
+            encode_ppm(fb, buffer);
+            sink = buffer.back();
+        });
+        // the same plus the file: open, a single write, close
+        const std::string filename = "./microbench.ppm";
+        run("create_ppm_image" + size, bytes, [&]()
+        {
+            sink = create_ppm_image(filename, fb, buffer);
+        });
+        std::remove(filename.c_str());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--min-time" && i + 1 < argc) min_seconds = strtod(argv[++i], nullptr);
+        else if (arg.size() > 0 && arg[0] != '-' && filter.empty()) filter = arg;
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--min-time SECONDS] [FILTER]" << std::endl;
+            return -1;
+        }
+    }
+
+    std::cout << "simd: " << simd_level_name(get_simd_level()) << std::endl;
+    for (const size_t n : {4096, 1 << 20}) bench_pack_unpack(n);
+    bench_draw_rectangle();
+    bench_load_texture("./textures/walltext.png");
+    bench_load_texture("./textures/monsters.png");
+    bench_ppm(1024, 512);
+    bench_ppm(3840, 2160);
+    return 0;
+}
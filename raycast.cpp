@@ -0,0 +1,488 @@
+#include "raycast.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if TFR_X86
+// packet kernels, each in its own file built for its instruction set
+void cast_rays_sse2(const map_view &map,
+                    const float x, const float y, const float *dir_x, const float *dir_y,
+                    const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+void cast_rays_avx2(const map_view &map,
+                    const float x, const float y, const float *dir_x, const float *dir_y,
+                    const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+void cast_rays_avx512(const map_view &map,
+                      const float x, const float y, const float *dir_x, const float *dir_y,
+                      const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+#endif
+
+namespace
+{
+    int lowest_bit(const uint64_t word) // word != 0
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long i;
+        _BitScanForward64(&i, word);
+        return int(i);
+#elif defined(_MSC_VER)
+        unsigned long i;
+        if (_BitScanForward(&i, uint32_t(word))) return int(i);
+        _BitScanForward(&i, uint32_t(word >> 32));
+        return int(i) + 32;
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    int highest_bit(const uint64_t word) // word != 0
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long i;
+        _BitScanReverse64(&i, word);
+        return int(i);
+#elif defined(_MSC_VER)
+        unsigned long i;
+        if (_BitScanReverse(&i, uint32_t(word >> 32))) return int(i) + 32;
+        _BitScanReverse(&i, uint32_t(word));
+        return int(i);
+#else
+        return 63 - __builtin_clzll(word);
+#endif
+    }
+
+    // first set bit among bits [lo, hi] of a line of occupancy bits, going up from lo (step > 0) or down from hi.
+    // -1 if there is none
+    int first_wall(const uint64_t *bits, const int lo, const int hi, const int step)
+    {
+        const int first = lo / 64, last = hi / 64;
+        const uint64_t lo_mask = ~uint64_t(0) << (lo % 64);
+        const uint64_t hi_mask = ~uint64_t(0) >> (63 - hi % 64);
+        if (step > 0)
+        {
+            for (int i = first; i <= last; i++)
+            {
+                const uint64_t word = bits[i] & (i == first ? lo_mask : ~uint64_t(0)) & (i == last ? hi_mask : ~uint64_t(0));
+                if (word) return i * 64 + lowest_bit(word);
+            }
+        }
+        else
+        {
+            for (int i = last; i >= first; i--)
+            {
+                const uint64_t word = bits[i] & (i == first ? lo_mask : ~uint64_t(0)) & (i == last ? hi_mask : ~uint64_t(0));
+                if (word) return i * 64 + highest_bit(word);
+            }
+        }
+        return -1;
+    }
+
+    // fills in res for a ray that stopped in the wall (map_x, map_y), at res.dist past the side res.side. Only now
+    // that the ray hit something does it read the cell
+    template<typename Map> ray_hit set_hit(ray_hit res, const Map &map, const int map_x, const int map_y,
+                                           const float x, const float y, const float dir_x, const float dir_y)
+    {
+        res.hit = true;
+        res.cell = wall_kind(map.at(map_x, map_y));
+        res.map_x = map_x;
+        res.map_y = map_y;
+        const float wall = res.side == 0 ? y + res.dist * dir_y : x + res.dist * dir_x;
+        res.text_x = wall - floorf(wall);
+        return res;
+    }
+
+    // the plain DDA, on any layout of the map: a map_view or a tiled_view
+    template<typename Map> ray_hit step_ray(const Map &map,
+                                            const float x, const float y, const float dir_x, const float dir_y, const float max_dist)
+    {
+        ray_hit res;
+
+        int map_x = int(floorf(x));
+        int map_y = int(floorf(y));
+        if (map_x < 0 || map_y < 0 || map_x >= int(map.w) || map_y >= int(map.h)) return res; // rays start in the map
+
+        // distance along the ray between two consecutive vertical (resp. horizontal) grid lines
+        const float delta_x = dir_x != 0.0f ? fabsf(1.0f / dir_x) : FLT_MAX;
+        const float delta_y = dir_y != 0.0f ? fabsf(1.0f / dir_y) : FLT_MAX;
+
+        // distance along the ray to the first vertical (resp. horizontal) grid line
+        const int step_x = dir_x < 0.0f ? -1 : 1;
+        const int step_y = dir_y < 0.0f ? -1 : 1;
+        float side_x = dir_x < 0.0f ? (x - map_x) * delta_x : (map_x + 1.0f - x) * delta_x;
+        float side_y = dir_y < 0.0f ? (y - map_y) * delta_y : (map_y + 1.0f - y) * delta_y;
+
+        for (;;)
+        {
+            // step to whichever grid line comes first, testing one bit each
+            if (side_x < side_y)
+            {
+                res.dist = side_x;
+                side_x += delta_x;
+                map_x += step_x;
+                res.side = 0;
+            }
+            else
+            {
+                res.dist = side_y;
+                side_y += delta_y;
+                map_y += step_y;
+                res.side = 1;
+            }
+            if (res.dist > max_dist) return res;
+            if (map_x < 0 || map_y < 0 || map_x >= int(map.w) || map_y >= int(map.h)) return res; // left the map
+            if (map.wall(map_x, map_y)) return set_hit(res, map, map_x, map_y, x, y, dir_x, dir_y);
+        }
+    }
+
+    // Runs shorter than this on average are taken one step at a time, scanning words doesn't pay for them
+    constexpr float min_run = 8.0f;
+
+    // Takes the run of steps along one axis that come before the next step along the other: n steps of delta from
+    // side, crossing cells pos + step, pos + 2 * step... of a single line of the map, size cells long, whose occupancy
+    // bits are bits. The cells of the run are checked at once by scanning words of bits. inv_delta is 1 / delta.
+    // Returns true if the ray is done: it hit a wall (pos is the wall), went past max_dist or left the map.
+    bool take_run(const uint64_t *bits, const int size, int &pos, const int step, float &side, const float delta,
+                  const float inv_delta, const float other_side, const float max_dist, float &dist)
+    {
+        // the steps at side, side + delta... that come before other_side, before the first one past max_dist
+        // and before the one that leaves the map: ceil() of the smallest count, side < other_side so it is at least 1
+        const float before_other = (other_side - side) * inv_delta;
+        const float before_far = (max_dist - side) * inv_delta + 1.0f;
+        const int before_edge = (step > 0 ? size - 1 - pos : pos) + 1;
+        const float steps = std::min(std::min(before_other, before_far), float(before_edge));
+        const int n = std::max(1, int(steps) + (steps > float(int(steps)) ? 1 : 0));
+
+        const int inside = std::min(n, before_edge - 1); // steps that land in the map
+        int wall = -1;
+        if (inside == 1) wall = (bits[(pos + step) / 64] >> ((pos + step) % 64)) & 1 ? pos + step : -1;
+        else if (inside > 1) wall = step > 0 ? first_wall(bits, pos + 1, pos + inside, 1) : first_wall(bits, pos - inside, pos - 1, -1);
+
+        const int k = wall >= 0 ? std::abs(wall - pos) : n; // steps actually taken
+        dist = side + (k - 1) * delta;
+        side += k * delta;
+        pos += k * step;
+        return wall >= 0 || dist > max_dist || k > inside;
+    }
+
+    // a single step, the bit of the cell it lands in is tested on its own. Same returns as take_run()
+    bool take_step(const uint64_t *bits, const int size, int &pos, const int step, float &side, const float delta,
+                   const float max_dist, float &dist)
+    {
+        dist = side;
+        side += delta;
+        pos += step;
+        return dist > max_dist || unsigned(pos) >= unsigned(size) || ((bits[unsigned(pos) / 64] >> (unsigned(pos) % 64)) & 1);
+    }
+
+    // DDA that jumps over boxes of empty cells, for the traversals that know of some. empty_box(map_x, map_y, box)
+    // returns false when it knows of no such box around the empty cell (map_x, map_y), or true and the box: cells
+    // box[0]..box[2] by box[1]..box[3], in the map and the cell among them. The ray then goes straight to the cell
+    // right behind the side of the box it leaves through, landing on a cell the plain DDA would have stepped on.
+    template<typename Map, typename F> ray_hit skip_ray(const Map &map,
+                                                        const float x, const float y, const float dir_x, const float dir_y,
+                                                        const float max_dist, const F &empty_box)
+    {
+        ray_hit res;
+
+        int map_x = int(floorf(x));
+        int map_y = int(floorf(y));
+        if (map_x < 0 || map_y < 0 || map_x >= int(map.w) || map_y >= int(map.h)) return res; // rays start in the map
+
+        const float delta_x = dir_x != 0.0f ? fabsf(1.0f / dir_x) : FLT_MAX;
+        const float delta_y = dir_y != 0.0f ? fabsf(1.0f / dir_y) : FLT_MAX;
+        const int step_x = dir_x < 0.0f ? -1 : 1;
+        const int step_y = dir_y < 0.0f ? -1 : 1;
+        float side_x = dir_x < 0.0f ? (x - map_x) * delta_x : (map_x + 1.0f - x) * delta_x;
+        float side_y = dir_y < 0.0f ? (y - map_y) * delta_y : (map_y + 1.0f - y) * delta_y;
+        const float inv_dir_x = dir_x != 0.0f ? 1.0f / dir_x : 0.0f; // distances to grid lines after a jump
+        const float inv_dir_y = dir_y != 0.0f ? 1.0f / dir_y : 0.0f;
+        bool jumped = false; // side_x and side_y are stale
+
+        for (;;)
+        {
+            int box[4];
+            if (!empty_box(map_x, map_y, box))
+            {
+                if (jumped)
+                {
+                    // back to dda steps after a jump, or a run of them: the next grid lines from where the ray is now
+                    side_x = dir_x != 0.0f ? ((step_x > 0 ? map_x + 1 : map_x) - x) * inv_dir_x : FLT_MAX;
+                    side_y = dir_y != 0.0f ? ((step_y > 0 ? map_y + 1 : map_y) - y) * inv_dir_y : FLT_MAX;
+                    jumped = false;
+                }
+                // a wall may be right there, a plain dda step
+                if (side_x < side_y)
+                {
+                    res.dist = side_x;
+                    side_x += delta_x;
+                    map_x += step_x;
+                    res.side = 0;
+                }
+                else
+                {
+                    res.dist = side_y;
+                    side_y += delta_y;
+                    map_y += step_y;
+                    res.side = 1;
+                }
+            }
+            else
+            {
+                // leave the box through whichever of its sides comes first, to the cell right behind that side. The
+                // other coordinate of the cell comes from the exit point, kept in the box against rounding (which
+                // also makes truncating as good as flooring, the box is in the map)
+                const int line_x = step_x > 0 ? box[2] + 1 : box[0];
+                const int line_y = step_y > 0 ? box[3] + 1 : box[1];
+                const float exit_x = dir_x != 0.0f ? (line_x - x) * inv_dir_x : FLT_MAX;
+                const float exit_y = dir_y != 0.0f ? (line_y - y) * inv_dir_y : FLT_MAX;
+                if (exit_x < exit_y)
+                {
+                    res.dist = exit_x;
+                    map_x = step_x > 0 ? line_x : line_x - 1;
+                    map_y = std::min(std::max(int(y + exit_x * dir_y), box[1]), box[3]);
+                    res.side = 0;
+                }
+                else
+                {
+                    res.dist = exit_y;
+                    map_x = std::min(std::max(int(x + exit_y * dir_x), box[0]), box[2]);
+                    map_y = step_y > 0 ? line_y : line_y - 1;
+                    res.side = 1;
+                }
+                jumped = true;
+            }
+
+            if (res.dist > max_dist) return res;
+            if (map_x < 0 || map_y < 0 || map_x >= int(map.w) || map_y >= int(map.h)) return res; // left the map
+            if (map.wall(map_x, map_y)) return set_hit(res, map, map_x, map_y, x, y, dir_x, dir_y);
+        }
+    }
+}
+
+
+ray_hit cast_ray(const map_view &map,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist)
+{
+    // steps along x between two steps along y is delta_y / delta_x = |dir_x / dir_y| on average, and the other way
+    // around. Rays close to an axis take long runs along it, those are checked a word of bits at a time. Others take
+    // plain steps
+    const bool runs_x = fabsf(dir_x) > min_run * fabsf(dir_y);
+    const bool runs_y = fabsf(dir_y) > min_run * fabsf(dir_x);
+    if (!runs_x && !runs_y) return step_ray(map, x, y, dir_x, dir_y, max_dist);
+
+    ray_hit res;
+
+    int map_x = int(floorf(x));
+    int map_y = int(floorf(y));
+    if (map_x < 0 || map_y < 0 || map_x >= int(map.w) || map_y >= int(map.h)) return res; // rays start in the map
+
+    // distance along the ray between two consecutive vertical (resp. horizontal) grid lines
+    const float delta_x = dir_x != 0.0f ? fabsf(1.0f / dir_x) : FLT_MAX;
+    const float delta_y = dir_y != 0.0f ? fabsf(1.0f / dir_y) : FLT_MAX;
+    const float inv_delta_x = fabsf(dir_x), inv_delta_y = fabsf(dir_y);
+
+    // distance along the ray to the first vertical (resp. horizontal) grid line
+    const int step_x = dir_x < 0.0f ? -1 : 1;
+    const int step_y = dir_y < 0.0f ? -1 : 1;
+    float side_x = dir_x < 0.0f ? (x - map_x) * delta_x : (map_x + 1.0f - x) * delta_x;
+    float side_y = dir_y < 0.0f ? (y - map_y) * delta_y : (map_y + 1.0f - y) * delta_y;
+
+    for (;;)
+    {
+        // step to whichever grid line comes first, or jump along with every other line of the same kind before
+        // the next line of the other kind: those steps stay in the same row (resp. column) of the map
+        bool done;
+        if (side_x < side_y)
+        {
+            const uint64_t *row = map.rows + map_y * map.row_words;
+            done = runs_x ? take_run(row, int(map.w), map_x, step_x, side_x, delta_x, inv_delta_x, side_y, max_dist, res.dist)
+                          : take_step(row, int(map.w), map_x, step_x, side_x, delta_x, max_dist, res.dist);
+            res.side = 0;
+        }
+        else
+        {
+            const uint64_t *col = map.cols + map_x * map.col_words;
+            done = runs_y ? take_run(col, int(map.h), map_y, step_y, side_y, delta_y, inv_delta_y, side_x, max_dist, res.dist)
+                          : take_step(col, int(map.h), map_y, step_y, side_y, delta_y, max_dist, res.dist);
+            res.side = 1;
+        }
+        if (!done) continue;
+        if (res.dist > max_dist) return res;
+        if (map_x < 0 || map_y < 0 || map_x >= int(map.w) || map_y >= int(map.h)) return res; // left the map
+        return set_hit(res, map, map_x, map_y, x, y, dir_x, dir_y);
+    }
+}
+
+ray_hit cast_ray(const tiled_view &map,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist)
+{
+    return step_ray(map, x, y, dir_x, dir_y, max_dist);
+}
+
+ray_hit cast_ray(const map_view &map, const coarse_grid &coarse,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist)
+{
+    return skip_ray(map, x, y, dir_x, dir_y, max_dist, [&](const int map_x, const int map_y, int box[4])
+    {
+        // the biggest empty block around the cell, if any
+        int level = 0;
+        while (level < coarse.levels() &&
+               coarse.empty(level + 1, size_t(map_x) >> ((level + 1) * coarse_shift), size_t(map_y) >> ((level + 1) * coarse_shift)))
+        {
+            level++;
+        }
+        if (level == 0) return false;
+        const int size = 1 << (level * coarse_shift);
+        box[0] = map_x & ~(size - 1);
+        box[1] = map_y & ~(size - 1);
+        box[2] = box[0] + size - 1;
+        box[3] = box[1] + size - 1;
+        return true;
+    });
+}
+
+ray_hit cast_ray(const map_view &map, const distance_field &field,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist)
+{
+    return skip_ray(map, x, y, dir_x, dir_y, max_dist, [&](const int map_x, const int map_y, int box[4])
+    {
+        // every cell less than d away from this one is empty
+        const int r = int(field.at(map_x, map_y)) - 1;
+        if (r <= 0) return false;
+        box[0] = std::max(map_x - r, 0);
+        box[1] = std::max(map_y - r, 0);
+        box[2] = std::min(map_x + r, int(map.w) - 1);
+        box[3] = std::min(map_y + r, int(map.h) - 1);
+        return true;
+    });
+}
+
+void cast_rays(const map_view &map,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    // packet lanes index the occupancy bits with 32 bit ints, very narrow maps pad their rows too much for that
+    const bool packets = map.h * map.row_words * 64 <= size_t(INT32_MAX);
+    switch (packets ? get_simd_level() : simd_level::scalar)
+    {
+#if TFR_X86
+        case simd_level::avx512: cast_rays_avx512(map, x, y, dir_x, dir_y, count, max_dist, img_h, hits, heights); return;
+        case simd_level::avx2: cast_rays_avx2(map, x, y, dir_x, dir_y, count, max_dist, img_h, hits, heights); return;
+        case simd_level::sse2: cast_rays_sse2(map, x, y, dir_x, dir_y, count, max_dist, img_h, hits, heights); return;
+#endif
+        default: break;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        hits[i] = cast_ray(map, x, y, dir_x[i], dir_y[i], max_dist);
+        heights[i] = hits[i].hit ? uint32_t(std::min(img_h / hits[i].dist, max_column_height)) : 0;
+    }
+}
+
+void cast_rays(const map_view &map, const coarse_grid &coarse,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        hits[i] = cast_ray(map, coarse, x, y, dir_x[i], dir_y[i], max_dist);
+        heights[i] = hits[i].hit ? uint32_t(std::min(img_h / hits[i].dist, max_column_height)) : 0;
+    }
+}
+
+void cast_rays(const map_view &map, const distance_field &field,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        hits[i] = cast_ray(map, field, x, y, dir_x[i], dir_y[i], max_dist);
+        heights[i] = hits[i].hit ? uint32_t(std::min(img_h / hits[i].dist, max_column_height)) : 0;
+    }
+}
+
+void march_rays(const map_view &map,
+                const float x, const float y, const float *dir_x, const float *dir_y,
+                const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        // the marcher walks unit steps along the angle of the ray, its distances are in units of length
+        const float dir_len = sqrtf(dir_x[i] * dir_x[i] + dir_y[i] * dir_y[i]);
+        hits[i] = march_ray(map, x, y, atan2f(dir_y[i], dir_x[i]), max_dist * dir_len);
+        hits[i].dist /= dir_len;
+        heights[i] = hits[i].hit && hits[i].dist > 0.0f ? uint32_t(std::min(img_h / hits[i].dist, max_column_height)) : 0;
+    }
+}
+
+void cast_rays(const tiled_view &map,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        hits[i] = cast_ray(map, x, y, dir_x[i], dir_y[i], max_dist);
+        heights[i] = hits[i].hit ? uint32_t(std::min(img_h / hits[i].dist, max_column_height)) : 0;
+    }
+}
+
+ray_hit march_ray(const map_view &map,
+                  const float x, const float y, const float angle, const float max_dist, const float step)
+{
+    ray_hit res;
+    for (float t = 0; t < max_dist; t += step)
+    {
+        float cx = x + t * cosf(angle);
+        float cy = y + t * sinf(angle);
+        if (cx < 0 || cy < 0 || cx >= map.w || cy >= map.h) break;
+
+        const uint8_t cell = map.at(size_t(cx), size_t(cy));
+        if (cell == empty_cell) continue;
+
+        res.hit = true;
+        res.cell = wall_kind(cell);
+        res.dist = t;
+        res.map_x = size_t(cx);
+        res.map_y = size_t(cy);
+        // the hit point is close to a grid line, the side is whichever one is closest
+        float hit_x = cx - floorf(cx + 0.5f);
+        float hit_y = cy - floorf(cy + 0.5f);
+        res.side = fabsf(hit_y) < fabsf(hit_x) ? 1 : 0;
+        const float wall = res.side == 0 ? cy : cx;
+        res.text_x = wall - floorf(wall);
+        break;
+    }
+    return res;
+}
+
+const char *traversal_name(const traversal t)
+{
+    switch (t)
+    {
+        case traversal::march: return "march";
+        case traversal::dda: return "dda";
+        case traversal::coarse: return "coarse";
+        case traversal::distance_field: return "distance-field";
+    }
+    return "unknown";
+}
+
+bool traversal_from_name(const std::string &name, traversal &t)
+{
+    for (const traversal candidate : {traversal::march, traversal::dda, traversal::coarse, traversal::distance_field})
+    {
+        if (name == traversal_name(candidate))
+        {
+            t = candidate;
+            return true;
+        }
+    }
+    return false;
+}
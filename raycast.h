@@ -0,0 +1,89 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "coarse_grid.h"
+#include "distance_field.h"
+#include "map.h"
+#include "tiled_map.h"
+
+// What a single ray found in the map
+struct ray_hit
+{
+    float dist = 0.0f;   // ray parameter t at the hit, hit point = (x, y) + t * (dir_x, dir_y)
+    float text_x = 0.0f; // where along the wall face the ray landed, in [0, 1)
+    size_t map_x = 0;    // map cell that was hit
+    size_t map_y = 0;
+    int side = 0;        // 0: the ray crossed a vertical grid line (x side), 1: a horizontal one (y side)
+    uint8_t cell = empty_cell; // the map cell that was hit, the kind of wall
+    bool hit = false;    // false if the ray left the map or went past max_dist
+};
+
+// Grid traversal (DDA): walks the map cells crossed by the ray one by one, visiting each cell exactly once.
+// The distance is exact, no stepping error. dir does not need to be normalized, dist is expressed in units of |dir|.
+ray_hit cast_ray(const map_view &map,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist);
+
+// Same as cast_ray(), on a map stored in tiles. Cell by cell only, rays don't take runs of a row at once here
+ray_hit cast_ray(const tiled_view &map,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist);
+
+// Same as cast_ray(), jumping over the empty blocks of coarse (built from map) in one step each: a ray crossing an
+// open area costs about as much as a ray hitting the wall next to it. It lands on the cells cast_ray() lands on, the
+// distances are computed from the start of the ray rather than added up step by step and may differ by rounding
+ray_hit cast_ray(const map_view &map, const coarse_grid &coarse,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist);
+
+// Same again, sphere tracing on field (built from map): from a cell at distance d of the nearest wall the ray jumps
+// out of the square of empty cells around it, and steps cell by cell next to walls
+ray_hit cast_ray(const map_view &map, const distance_field &field,
+                 const float x, const float y, const float dir_x, const float dir_y, const float max_dist);
+
+// projected wall heights are clamped to this, 2^24 is still exact as a float and far above any screen height
+constexpr float max_column_height = 16777216.0f;
+
+// Casts count rays from (x, y) at once, in packets of 4, 8 or 16 lanes depending on get_simd_level() (see simd.h).
+// hits[i] is what cast_ray() would return for the ith ray, heights[i] is its projected wall height img_h / dist
+// (0 when nothing was hit).
+void cast_rays(const map_view &map,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+
+// Same as cast_rays(), one ray at a time with empty-space skipping: better than packets once rays cross open areas
+void cast_rays(const map_view &map, const coarse_grid &coarse,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+void cast_rays(const map_view &map, const distance_field &field,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+
+// Same as cast_rays(), one ray at a time on a map stored in tiles
+void cast_rays(const tiled_view &map,
+               const float x, const float y, const float *dir_x, const float *dir_y,
+               const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+
+// Same as cast_rays() with march_ray(): hits are converted to units of |dir| like the others
+void march_rays(const map_view &map,
+                const float x, const float y, const float *dir_x, const float *dir_y,
+                const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights);
+
+// The original fixed step ray marcher, kept around to compare against cast_ray()
+ray_hit march_ray(const map_view &map,
+                  const float x, const float y, const float angle, const float max_dist, const float step = 0.01f);
+
+// How rays find their way through the map, see the functions above
+enum class traversal
+{
+    march,          // march_rays(), the original fixed steps
+    dda,            // cast_rays(), packets of dda
+    coarse,         // cast_rays() with a coarse_grid
+    distance_field, // cast_rays() with a distance_field
+};
+
+const char *traversal_name(const traversal t);
+bool traversal_from_name(const std::string &name, traversal &t); // the other way around, false for an unknown name
+
+#endif // !RAYCAST_H
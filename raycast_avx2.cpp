@@ -0,0 +1,93 @@
+// AVX2 build of the packet ray caster, 8 rays per packet. See raycast_simd.h
+// Built with /arch:AVX2 (see the project file), only called once detect_simd_level() said the cpu can run it.
+#include "raycast.h"
+#include "simd.h"
+
+#include <cfloat>
+#include <cstdint>
+
+#if TFR_X86
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+#include <immintrin.h>
+
+namespace
+{
+    struct avx2
+    {
+        static const int width = 8;
+        typedef __m256 vf;
+        typedef __m256i vi;
+        typedef __m256i vm;
+
+        static vf set1(const float a) { return _mm256_set1_ps(a); }
+        static vi set1i(const int a) { return _mm256_set1_epi32(a); }
+        static vf load(const float *p) { return _mm256_load_ps(p); }
+        static void store(float *p, const vf a) { _mm256_store_ps(p, a); }
+        static void storei(int32_t *p, const vi a) { _mm256_store_si256(reinterpret_cast<__m256i *>(p), a); }
+
+        static vf add(const vf a, const vf b) { return _mm256_add_ps(a, b); }
+        static vf sub(const vf a, const vf b) { return _mm256_sub_ps(a, b); }
+        static vf mul(const vf a, const vf b) { return _mm256_mul_ps(a, b); }
+        static vf div(const vf a, const vf b) { return _mm256_div_ps(a, b); }
+        static vf min(const vf a, const vf b) { return _mm256_min_ps(a, b); }
+        static vf abs(const vf a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static vi cvtfi(const vf a) { return _mm256_cvttps_epi32(a); }
+        static vf cvtif(const vi a) { return _mm256_cvtepi32_ps(a); }
+
+        static vm lt(const vf a, const vf b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+        static vm gt(const vf a, const vf b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+        static vm eq(const vf a, const vf b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)); }
+        static vi addi(const vi a, const vi b) { return _mm256_add_epi32(a, b); }
+        static vm lti(const vi a, const vi b) { return _mm256_cmpgt_epi32(b, a); }
+        static vm gti(const vi a, const vi b) { return _mm256_cmpgt_epi32(a, b); }
+        static vm eqi(const vi a, const vi b) { return _mm256_cmpeq_epi32(a, b); }
+
+        static vm all() { return _mm256_set1_epi32(-1); }
+        static vm none() { return _mm256_setzero_si256(); }
+        static vm and_(const vm a, const vm b) { return _mm256_and_si256(a, b); }
+        static vm or_(const vm a, const vm b) { return _mm256_or_si256(a, b); }
+        static vm and_not(const vm a, const vm b) { return _mm256_andnot_si256(b, a); }
+        static bool any(const vm m) { return !_mm256_testz_si256(m, m); }
+        static int bits(const vm m) { return _mm256_movemask_ps(_mm256_castsi256_ps(m)); }
+
+        static vf select(const vm m, const vf a, const vf b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(m)); }
+        static vi selecti(const vm m, const vi a, const vi b) { return _mm256_blendv_epi8(b, a, m); }
+        static vi maski(const vm m, const vi a) { return _mm256_and_si256(m, a); }
+
+        // gathers the aligned 32 bit word holding each byte and shifts the byte out. An aligned word never
+        // straddles a page, so this can't fault even on the last cell of the map.
+        static vi gather_u8(const uint8_t *map, const vi idx, const vm m)
+        {
+            const int misalign = int(reinterpret_cast<uintptr_t>(map) & 3);
+            const vi offset = _mm256_add_epi32(idx, _mm256_set1_epi32(misalign));
+            const vi word = _mm256_and_si256(offset, _mm256_set1_epi32(~3));
+            const vi shift = _mm256_slli_epi32(_mm256_and_si256(offset, _mm256_set1_epi32(3)), 3);
+            const vi words = _mm256_mask_i32gather_epi32(none(), reinterpret_cast<const int *>(map - misalign), word, m, 1);
+            return _mm256_and_si256(_mm256_srlv_epi32(words, shift), _mm256_set1_epi32(0xff));
+        }
+        // bits are little endian 64 bit words, read as 32 bit ones
+        static vi gather_bit(const uint64_t *bits, const vi idx, const vm m)
+        {
+            const vi words = _mm256_mask_i32gather_epi32(none(), reinterpret_cast<const int *>(bits), _mm256_srli_epi32(idx, 5), m, 4);
+            return _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(idx, _mm256_set1_epi32(31))), _mm256_set1_epi32(1));
+        }
+    };
+
+#include "raycast_simd.h"
+}
+
+void cast_rays_avx2(const map_view &map,
+                    const float x, const float y, const float *dir_x, const float *dir_y,
+                    const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    cast_ray_packets<avx2>(map, x, y, dir_x, dir_y, count, max_dist, img_h, hits, heights);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+#endif
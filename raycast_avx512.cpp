@@ -0,0 +1,91 @@
+// AVX-512 build of the packet ray caster, 16 rays per packet. See raycast_simd.h
+// Built with /arch:AVX512 (see the project file), only called once detect_simd_level() said the cpu can run it.
+#include "raycast.h"
+#include "simd.h"
+
+#include <cfloat>
+#include <cstdint>
+
+#if TFR_X86
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx512f")
+#endif
+#include <immintrin.h>
+
+namespace
+{
+    struct avx512
+    {
+        static const int width = 16;
+        typedef __m512 vf;
+        typedef __m512i vi;
+        typedef __mmask16 vm;
+
+        static vf set1(const float a) { return _mm512_set1_ps(a); }
+        static vi set1i(const int a) { return _mm512_set1_epi32(a); }
+        static vf load(const float *p) { return _mm512_load_ps(p); }
+        static void store(float *p, const vf a) { _mm512_store_ps(p, a); }
+        static void storei(int32_t *p, const vi a) { _mm512_store_si512(p, a); }
+
+        static vf add(const vf a, const vf b) { return _mm512_add_ps(a, b); }
+        static vf sub(const vf a, const vf b) { return _mm512_sub_ps(a, b); }
+        static vf mul(const vf a, const vf b) { return _mm512_mul_ps(a, b); }
+        static vf div(const vf a, const vf b) { return _mm512_div_ps(a, b); }
+        static vf min(const vf a, const vf b) { return _mm512_min_ps(a, b); }
+        static vf abs(const vf a) { return _mm512_abs_ps(a); }
+        static vi cvtfi(const vf a) { return _mm512_cvttps_epi32(a); }
+        static vf cvtif(const vi a) { return _mm512_cvtepi32_ps(a); }
+
+        static vm lt(const vf a, const vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+        static vm gt(const vf a, const vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+        static vm eq(const vf a, const vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+        static vi addi(const vi a, const vi b) { return _mm512_add_epi32(a, b); }
+        static vm lti(const vi a, const vi b) { return _mm512_cmplt_epi32_mask(a, b); }
+        static vm gti(const vi a, const vi b) { return _mm512_cmpgt_epi32_mask(a, b); }
+        static vm eqi(const vi a, const vi b) { return _mm512_cmpeq_epi32_mask(a, b); }
+
+        static vm all() { return vm(0xffff); }
+        static vm none() { return vm(0); }
+        static vm and_(const vm a, const vm b) { return vm(a & b); }
+        static vm or_(const vm a, const vm b) { return vm(a | b); }
+        static vm and_not(const vm a, const vm b) { return vm(a & ~b); }
+        static bool any(const vm m) { return m != 0; }
+        static int bits(const vm m) { return int(m); }
+
+        static vf select(const vm m, const vf a, const vf b) { return _mm512_mask_blend_ps(m, b, a); }
+        static vi selecti(const vm m, const vi a, const vi b) { return _mm512_mask_blend_epi32(m, b, a); }
+        static vi maski(const vm m, const vi a) { return _mm512_maskz_mov_epi32(m, a); }
+
+        // same aligned word trick as the avx2 build
+        static vi gather_u8(const uint8_t *map, const vi idx, const vm m)
+        {
+            const int misalign = int(reinterpret_cast<uintptr_t>(map) & 3);
+            const vi offset = _mm512_add_epi32(idx, _mm512_set1_epi32(misalign));
+            const vi word = _mm512_and_si512(offset, _mm512_set1_epi32(~3));
+            const vi shift = _mm512_slli_epi32(_mm512_and_si512(offset, _mm512_set1_epi32(3)), 3);
+            const vi words = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, word, map - misalign, 1);
+            return _mm512_and_si512(_mm512_srlv_epi32(words, shift), _mm512_set1_epi32(0xff));
+        }
+        static vi gather_bit(const uint64_t *bits, const vi idx, const vm m)
+        {
+            const vi words = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, _mm512_srli_epi32(idx, 5), bits, 4);
+            return _mm512_and_si512(_mm512_srlv_epi32(words, _mm512_and_si512(idx, _mm512_set1_epi32(31))), _mm512_set1_epi32(1));
+        }
+    };
+
+#include "raycast_simd.h"
+}
+
+void cast_rays_avx512(const map_view &map,
+                      const float x, const float y, const float *dir_x, const float *dir_y,
+                      const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    cast_ray_packets<avx512>(map, x, y, dir_x, dir_y, count, max_dist, img_h, hits, heights);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+#endif
@@ -0,0 +1,164 @@
+#ifndef RAYCAST_SIMD_H
+#define RAYCAST_SIMD_H
+
+// Packet version of cast_ray(): V::width adjacent rays walk through the map together, every lane doing exactly
+// what cast_ray() does for its own ray. Lanes drop out as they hit a wall or leave the map, the packet is done
+// once they all did. Adjacent columns are coherent, so lanes rarely wait on each other for long.
+//
+// It is written once against the small vector wrappers of raycast_sse2.cpp, raycast_avx2.cpp and raycast_avx512.cpp.
+// Only include it from those files, inside their anonymous namespace: every instantiation has to stay local to a
+// file compiled for its own instruction set, or the linker could pick an avx512 copy for everybody.
+//
+// A wrapper V provides:
+//   vf / vi / vm: vector of floats, of 32 bit ints and lane mask
+//   set1, set1i, load, store, storei, add, sub, mul, div, min, abs, cvtfi (truncating), cvtif
+//   lt, gt, eq on floats, addi, lti, gti, eqi on ints, all of them returning masks
+//   all, none, and_, or_, and_not(a, b) = a & ~b, any, bits (one bit per lane)
+//   select(m, a, b) = m ? a : b, selecti, maski(m, a) = m ? a : 0
+//   gather_u8(cells, idx, m): cells[idx] for the lanes in m, 0 for the others
+//   gather_bit(bits, idx, m): bit idx of the array of words bits for the lanes in m, 0 for the others
+//
+// Lanes walk on the occupancy bits of the map, the cells are only read for the lanes that hit something. Only the
+// fields of map are read here: no member function of it may be instantiated with wide instructions.
+template<typename V> void cast_ray_packets(const map_view &map,
+                                           const float x, const float y, const float *dir_x, const float *dir_y,
+                                           const size_t count, const float max_dist, const float img_h,
+                                           ray_hit *hits, uint32_t *heights)
+{
+    typedef typename V::vf vf;
+    typedef typename V::vi vi;
+    typedef typename V::vm vm;
+    const int width = V::width;
+
+    // every ray starts from the same cell
+    const int map_x0 = int(x) - (x < int(x) ? 1 : 0);
+    const int map_y0 = int(y) - (y < int(y) ? 1 : 0);
+    const size_t map_w = map.w, map_h = map.h;
+    if (map_x0 < 0 || map_y0 < 0 || map_x0 >= int(map_w) || map_y0 >= int(map_h))
+    { // rays start in the map, like in cast_ray(): from outside none of them hits anything. Fields one by one, as below
+        for (size_t i = 0; i < count; i++)
+        {
+            ray_hit &res = hits[i];
+            res.dist = 0.0f;
+            res.text_x = 0.0f;
+            res.map_x = 0;
+            res.map_y = 0;
+            res.side = 0;
+            res.cell = empty_cell;
+            res.hit = false;
+            heights[i] = 0;
+        }
+        return;
+    }
+    const int row_bits = int(map.row_words * 64); // bits from one row of the occupancy bits to the next
+
+    const vf zero = V::set1(0.0f);
+    const vf one = V::set1(1.0f);
+    const vf px = V::set1(x);
+    const vf py = V::set1(y);
+    const vf fx0 = V::set1(float(map_x0));
+    const vf fy0 = V::set1(float(map_y0));
+    const vf far_dist = V::set1(max_dist);
+    const vf screen_h = V::set1(img_h);
+    const vf max_height = V::set1(max_column_height);
+    const vi zero_i = V::set1i(0);
+    const vi one_i = V::set1i(1);
+    const vi last_x = V::set1i(int(map_w) - 1);
+    const vi last_y = V::set1i(int(map_h) - 1);
+
+    alignas(64) float in_x[16], in_y[16];
+    alignas(64) float out_dist[16], out_text[16];
+    alignas(64) int32_t out_side[16], out_cell[16], out_x[16], out_y[16], out_height[16];
+
+    for (size_t base = 0; base < count; base += width)
+    {
+        // the last packet may be partial, its spare lanes trace copies of the last ray
+        const size_t n = count - base < size_t(width) ? count - base : size_t(width);
+        for (int k = 0; k < width; k++)
+        {
+            const size_t i = base + (size_t(k) < n ? k : n - 1);
+            in_x[k] = dir_x[i];
+            in_y[k] = dir_y[i];
+        }
+        const vf dx = V::load(in_x);
+        const vf dy = V::load(in_y);
+
+        // same setup as cast_ray(), see there
+        const vm neg_x = V::lt(dx, zero);
+        const vm neg_y = V::lt(dy, zero);
+        const vf delta_x = V::select(V::eq(dx, zero), V::set1(FLT_MAX), V::abs(V::div(one, dx)));
+        const vf delta_y = V::select(V::eq(dy, zero), V::set1(FLT_MAX), V::abs(V::div(one, dy)));
+        const vi step_x = V::selecti(neg_x, V::set1i(-1), one_i);
+        const vi step_y = V::selecti(neg_y, V::set1i(-1), one_i);
+        const vi step_iy = V::selecti(neg_y, V::set1i(-int(map_w)), V::set1i(int(map_w))); // step_y in the cells
+        const vi step_by = V::selecti(neg_y, V::set1i(-row_bits), V::set1i(row_bits));   // step_y in the occupancy bits
+        vf side_x = V::select(neg_x, V::mul(V::sub(px, fx0), delta_x), V::mul(V::sub(V::add(fx0, one), px), delta_x));
+        vf side_y = V::select(neg_y, V::mul(V::sub(py, fy0), delta_y), V::mul(V::sub(V::add(fy0, one), py), delta_y));
+
+        vi mx = V::set1i(map_x0);
+        vi my = V::set1i(map_y0);
+        vi idx = V::set1i(map_x0 + map_y0 * int(map_w));
+        vi bit = V::set1i(map_x0 + map_y0 * row_bits);
+        vf dist = zero;
+        vi side = zero_i;
+        vm hit = V::none();
+        vm active = V::all();
+
+        while (V::any(active))
+        {
+            const vm in_x_step = V::and_(active, V::lt(side_x, side_y));
+            const vm in_y_step = V::and_not(active, in_x_step);
+
+            dist = V::select(in_x_step, side_x, V::select(in_y_step, side_y, dist));
+            side_x = V::select(in_x_step, V::add(side_x, delta_x), side_x);
+            side_y = V::select(in_y_step, V::add(side_y, delta_y), side_y);
+            mx = V::addi(mx, V::maski(in_x_step, step_x));
+            my = V::addi(my, V::maski(in_y_step, step_y));
+            idx = V::addi(idx, V::addi(V::maski(in_x_step, step_x), V::maski(in_y_step, step_iy)));
+            bit = V::addi(bit, V::addi(V::maski(in_x_step, step_x), V::maski(in_y_step, step_by)));
+            side = V::selecti(in_x_step, zero_i, V::selecti(in_y_step, one_i, side));
+
+            // lanes that went too far or left the map are done, without a hit
+            const vm outside = V::or_(V::or_(V::lti(mx, zero_i), V::gti(mx, last_x)),
+                                      V::or_(V::lti(my, zero_i), V::gti(my, last_y)));
+            active = V::and_not(active, V::or_(V::gt(dist, far_dist), outside));
+
+            const vm wall = V::and_not(active, V::eqi(V::gather_bit(map.rows, bit, active), zero_i));
+            hit = V::or_(hit, wall);
+            active = V::and_not(active, wall);
+        }
+        const vi cell = V::gather_u8(map.cells, idx, hit);
+
+        // hit points are inside the map, so truncating is flooring
+        const vf wall = V::select(V::eqi(side, zero_i), V::add(py, V::mul(dist, dy)), V::add(px, V::mul(dist, dx)));
+        const vf text_x = V::sub(wall, V::cvtif(V::cvtfi(wall)));
+        const vi height = V::maski(hit, V::cvtfi(V::min(V::div(screen_h, dist), max_height)));
+
+        V::store(out_dist, dist);
+        V::store(out_text, text_x);
+        V::storei(out_side, side);
+        V::storei(out_cell, cell);
+        V::storei(out_x, mx);
+        V::storei(out_y, my);
+        V::storei(out_height, height);
+        const int hit_bits = V::bits(hit);
+
+        // fields are set one by one rather than through ray_hit(), whose inline constructor could otherwise be
+        // emitted from here with wide instructions and picked by the linker for everybody
+        for (size_t k = 0; k < n; k++)
+        {
+            const bool lane_hit = (hit_bits & (1 << k)) != 0;
+            ray_hit &res = hits[base + k];
+            res.dist = out_dist[k];
+            res.side = out_side[k];
+            res.hit = lane_hit;
+            res.cell = lane_hit ? wall_kind(uint8_t(out_cell[k])) : empty_cell;
+            res.map_x = lane_hit ? size_t(out_x[k]) : 0;
+            res.map_y = lane_hit ? size_t(out_y[k]) : 0;
+            res.text_x = lane_hit ? out_text[k] : 0.0f;
+            heights[base + k] = uint32_t(out_height[k]);
+        }
+    }
+}
+
+#endif // !RAYCAST_SIMD_H
@@ -0,0 +1,93 @@
+// SSE2 build of the packet ray caster, 4 rays per packet. See raycast_simd.h
+#include "raycast.h"
+#include "simd.h"
+
+#include <cfloat>
+#include <cstdint>
+
+#if TFR_X86
+#include <emmintrin.h>
+
+namespace
+{
+    struct sse2
+    {
+        static const int width = 4;
+        typedef __m128 vf;
+        typedef __m128i vi;
+        typedef __m128i vm;
+
+        static vf set1(const float a) { return _mm_set1_ps(a); }
+        static vi set1i(const int a) { return _mm_set1_epi32(a); }
+        static vf load(const float *p) { return _mm_load_ps(p); }
+        static void store(float *p, const vf a) { _mm_store_ps(p, a); }
+        static void storei(int32_t *p, const vi a) { _mm_store_si128(reinterpret_cast<__m128i *>(p), a); }
+
+        static vf add(const vf a, const vf b) { return _mm_add_ps(a, b); }
+        static vf sub(const vf a, const vf b) { return _mm_sub_ps(a, b); }
+        static vf mul(const vf a, const vf b) { return _mm_mul_ps(a, b); }
+        static vf div(const vf a, const vf b) { return _mm_div_ps(a, b); }
+        static vf min(const vf a, const vf b) { return _mm_min_ps(a, b); }
+        static vf abs(const vf a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static vi cvtfi(const vf a) { return _mm_cvttps_epi32(a); }
+        static vf cvtif(const vi a) { return _mm_cvtepi32_ps(a); }
+
+        static vm lt(const vf a, const vf b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+        static vm gt(const vf a, const vf b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+        static vm eq(const vf a, const vf b) { return _mm_castps_si128(_mm_cmpeq_ps(a, b)); }
+        static vi addi(const vi a, const vi b) { return _mm_add_epi32(a, b); }
+        static vm lti(const vi a, const vi b) { return _mm_cmplt_epi32(a, b); }
+        static vm gti(const vi a, const vi b) { return _mm_cmpgt_epi32(a, b); }
+        static vm eqi(const vi a, const vi b) { return _mm_cmpeq_epi32(a, b); }
+
+        static vm all() { return _mm_set1_epi32(-1); }
+        static vm none() { return _mm_setzero_si128(); }
+        static vm and_(const vm a, const vm b) { return _mm_and_si128(a, b); }
+        static vm or_(const vm a, const vm b) { return _mm_or_si128(a, b); }
+        static vm and_not(const vm a, const vm b) { return _mm_andnot_si128(b, a); }
+        static bool any(const vm m) { return _mm_movemask_epi8(m) != 0; }
+        static int bits(const vm m) { return _mm_movemask_ps(_mm_castsi128_ps(m)); }
+
+        static vf select(const vm m, const vf a, const vf b)
+        {
+            const vf mf = _mm_castsi128_ps(m);
+            return _mm_or_ps(_mm_and_ps(mf, a), _mm_andnot_ps(mf, b));
+        }
+        static vi selecti(const vm m, const vi a, const vi b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+        static vi maski(const vm m, const vi a) { return _mm_and_si128(m, a); }
+
+        // no gather before avx2, fetch lane by lane
+        static vi gather_u8(const uint8_t *map, const vi idx, const vm m)
+        {
+            alignas(16) int32_t i[4], active[4], res[4];
+            storei(i, idx);
+            storei(active, m);
+            for (int k = 0; k < 4; k++)
+            {
+                res[k] = active[k] ? static_cast<unsigned char>(map[i[k]]) : 0;
+            }
+            return _mm_load_si128(reinterpret_cast<const __m128i *>(res));
+        }
+        static vi gather_bit(const uint64_t *bits, const vi idx, const vm m)
+        {
+            alignas(16) int32_t i[4], active[4], res[4];
+            storei(i, idx);
+            storei(active, m);
+            for (int k = 0; k < 4; k++)
+            {
+                res[k] = active[k] ? int32_t((bits[i[k] / 64] >> (i[k] % 64)) & 1) : 0;
+            }
+            return _mm_load_si128(reinterpret_cast<const __m128i *>(res));
+        }
+    };
+
+#include "raycast_simd.h"
+}
+
+void cast_rays_sse2(const map_view &map,
+                    const float x, const float y, const float *dir_x, const float *dir_y,
+                    const size_t count, const float max_dist, const float img_h, ray_hit *hits, uint32_t *heights)
+{
+    cast_ray_packets<sse2>(map, x, y, dir_x, dir_y, count, max_dist, img_h, hits, heights);
+}
+#endif
@@ -0,0 +1,363 @@
+#include "render.h"
+#include "image.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if TFR_X86
+size_t fill_span_avx2(uint32_t *dst, const size_t n, const uint32_t *texels, const uint32_t shift,
+                      const uint32_t u, const uint32_t v, const uint32_t du, const uint32_t dv); // image_avx2.cpp
+#endif
+
+column_sampler make_column_sampler(const uint32_t *texture_column, const size_t text_size, const size_t column_height, const size_t img_h)
+{
+    column_sampler s;
+    s.texels = texture_column;
+    if (column_height == 0) return s;
+
+    // the column is centered on the horizon, its top may well be above the image
+    const long long top = (long long)(img_h / 2) - (long long)(column_height / 2);
+    s.y0 = size_t(std::max(top, 0LL));
+    s.y1 = size_t(std::min(top + (long long)column_height, (long long)img_h));
+    // (column_height - 1) * step stays below text_size << 16, so v >> 16 never leaves the texture column
+    s.step = uint32_t((uint64_t(text_size) << 16) / column_height);
+    s.v = uint32_t(uint64_t(s.y0 - top) * s.step);
+    return s;
+}
+
+void draw_span(uint32_t *img_span, const size_t n, const span_sampler &s)
+{
+    size_t i = 0;
+#if TFR_X86
+    if (get_simd_level() >= simd_level::avx2) i = fill_span_avx2(img_span, n, s.texels, s.shift, s.u, s.v, s.du, s.dv);
+#endif
+    span_sampler rest = s;
+    rest.u += uint32_t(i) * s.du;
+    rest.v += uint32_t(i) * s.dv;
+    fill_span(img_span + i, 1, n - i, rest);
+}
+
+void cast_floor_ceiling(const image_view view, const column_layout layout, const scene &sc, const camera &cam, thread_pool &pool)
+{
+    // rows of the 3d view are columns of a column-major image
+    const bool transposed = layout == column_layout::column_major;
+    const size_t img_w = transposed ? view.height() : view.width();
+    const size_t img_h = transposed ? view.width() : view.height();
+    const size_t horizon = img_h / 2; // where walls are centered, see make_column_sampler()
+    const size_t size = sc.walltext.size();
+    uint32_t shift = 0;
+    while ((size_t(1) << shift) < size) shift++;
+    assert(size == 0 || size == size_t(1) << shift);
+
+    // a row without a texture samples a 1x1 texture of its color, the row-major path fills it directly
+    const uint32_t ceiling_color = sc.ceiling_color, floor_color = sc.floor_color;
+    auto make_span_sampler = [&](const size_t y)
+    {
+        span_sampler s;
+        const bool ceiling = y < horizon;
+        const size_t text_id = ceiling ? sc.ceiling_texture : sc.floor_texture;
+        if (text_id >= sc.walltext.count())
+        {
+            s.texels = ceiling ? &ceiling_color : &floor_color;
+            return s;
+        }
+
+        // the floor seen through row y is at the distance where a wall would be 2 * p pixels high, p pixels
+        // being the distance from the center of the row to the horizon. The ceiling is its mirror image
+        const float p = ceiling ? horizon - (y + 0.5f) : (y + 0.5f) - horizon;
+        const float row_dist = img_h / (2.0f * p);
+        // the row crosses the map from the left ray (dir - plane) to the right one (dir + plane), see ray_table
+        const float start_x = cam.x + row_dist * (cam.dir_x - cam.plane_x);
+        const float start_y = cam.y + row_dist * (cam.dir_y - cam.plane_y);
+        const float step_x = row_dist * 2.0f * cam.plane_x / img_w;
+        const float step_y = row_dist * 2.0f * cam.plane_y / img_w;
+
+        // a wall at row_dist samples this level, so does the floor next to it
+        const size_t level = sc.walltext.level_for_height(size_t(2.0f * p));
+        s.texels = sc.walltext.texture(text_id, level);
+        s.shift = shift - uint32_t(level);
+        // one map cell is one texture, 2^16 fixed point units per texel: truncating to 32 bits wraps the cells
+        const double scale = double(size_t(1) << s.shift) * 65536.0;
+        s.u = uint32_t(int64_t(floor(start_x * scale)));
+        s.v = uint32_t(int64_t(floor(start_y * scale)));
+        s.du = uint32_t(int32_t(step_x * scale));
+        s.dv = uint32_t(int32_t(step_y * scale));
+        return s;
+    };
+
+    // in a column-major image, 16 rows of the 3d view are a cache line of every row of the image
+    const size_t band_h = 16;
+    const size_t nbands = (img_h + band_h - 1) / band_h;
+    pool.parallel_for(nbands, [&](const size_t band)
+    {
+        const size_t y0 = band * band_h;
+        const size_t y1 = std::min(img_h, y0 + band_h);
+        if (!transposed)
+        {
+            for (size_t y = y0; y < y1; y++)
+            {
+                const span_sampler s = make_span_sampler(y);
+                if (s.texels == &ceiling_color || s.texels == &floor_color) std::fill_n(view.row(y), img_w, *s.texels);
+                else draw_span(view.row(y), img_w, s);
+            }
+            return;
+        }
+
+        // the band is drawn row-major a block at a time into a buffer that stays in L1, then transposed into place:
+        // every row of the image gets 16 contiguous pixels at once rather than one pixel from each of 16 passes
+        span_sampler s[band_h];
+        for (size_t y = y0; y < y1; y++) s[y - y0] = make_span_sampler(y);
+        uint32_t block[band_h * transpose_block];
+        for (size_t x0 = 0; x0 < img_w; x0 += transpose_block)
+        {
+            const size_t n = std::min(transpose_block, img_w - x0);
+            for (size_t y = y0; y < y1; y++)
+            {
+                span_sampler &row = s[y - y0];
+                draw_span(block + (y - y0) * transpose_block, n, row);
+                row.u += uint32_t(n) * row.du;
+                row.v += uint32_t(n) * row.dv;
+            }
+            transpose(image_view(block, n, y1 - y0, transpose_block), view.sub(y0, x0, y1 - y0, n));
+        }
+    });
+}
+
+void fill_sky_floor(const image_view view, const column_layout layout, const uint32_t ceiling, const uint32_t floor,
+                    thread_pool &pool, const bool streaming)
+{
+    // the horizon is a row of the 3d view, in a column-major image it is a column
+    const bool transposed = layout == column_layout::column_major;
+    const size_t horizon = (transposed ? view.width() : view.height()) / 2;
+    const size_t band_h = 16;
+    const size_t nbands = (view.height() + band_h - 1) / band_h;
+    pool.parallel_for(nbands, [&](const size_t band)
+    {
+        const image_view rows = view.sub(0, band * band_h, view.width(), band_h);
+        if (transposed)
+        {
+            clear_image(rows.sub(0, 0, horizon, rows.height()), ceiling, streaming);
+            clear_image(rows.sub(horizon, 0, rows.width() - horizon, rows.height()), floor, streaming);
+        }
+        else
+        {
+            const size_t y = band * band_h;
+            const size_t sky_h = horizon > y ? std::min(horizon - y, rows.height()) : 0;
+            clear_image(rows.sub(0, 0, rows.width(), sky_h), ceiling, streaming);
+            clear_image(rows.sub(0, sky_h, rows.width(), rows.height() - sky_h), floor, streaming);
+        }
+    });
+}
+
+void render_walls(const image_view view, const column_layout layout, const scene &sc, const camera &cam, const ray_table &rays,
+                  const float max_dist, thread_pool &pool, std::vector<ray_hit> &hits, const size_t tile_w)
+{
+    assert(tile_w > 0);
+    const bool transposed = layout == column_layout::column_major;
+    const size_t ncolumns = rays.size();
+    const size_t img_h = transposed ? view.width() : view.height();
+    assert(ncolumns == (transposed ? view.height() : view.width()));
+    assert(sc.colors.size() >= max_wall_kinds); // so map cells never need a check
+    assert(sc.ray_mode != traversal::coarse || sc.coarse);
+    assert(sc.ray_mode != traversal::distance_field || sc.field);
+    hits.resize(ncolumns);
+    // column x starts at first_pixel + x * column_step, its pixels are pixel_step apart
+    uint32_t *first_pixel = view.row(0);
+    const size_t column_step = transposed ? view.pitch() : 1;
+    const size_t pixel_step = transposed ? 1 : view.pitch();
+
+    const size_t ntiles = (ncolumns + tile_w - 1) / tile_w;
+    pool.parallel_for(ntiles, [&](const size_t tile)
+    {
+        const size_t end = std::min(ncolumns, (tile + 1) * tile_w);
+        uint32_t heights[64];
+        for (size_t first = tile * tile_w; first < end; first += 64)
+        {
+            const size_t n = std::min<size_t>(64, end - first);
+            const float *dx = rays.dir_x() + first, *dy = rays.dir_y() + first;
+            ray_hit *out = hits.data() + first;
+            switch (sc.ray_mode)
+            {
+                case traversal::march: march_rays(sc.map, cam.x, cam.y, dx, dy, n, max_dist, float(img_h), out, heights); break;
+                case traversal::dda:
+                    if (sc.tiles.cells) cast_rays(sc.tiles, cam.x, cam.y, dx, dy, n, max_dist, float(img_h), out, heights);
+                    else cast_rays(sc.map, cam.x, cam.y, dx, dy, n, max_dist, float(img_h), out, heights);
+                    break;
+                case traversal::coarse: cast_rays(sc.map, *sc.coarse, cam.x, cam.y, dx, dy, n, max_dist, float(img_h), out, heights); break;
+                case traversal::distance_field: cast_rays(sc.map, *sc.field, cam.x, cam.y, dx, dy, n, max_dist, float(img_h), out, heights); break;
+            }
+
+            for (size_t k = 0; k < n; k++)
+            {
+                const ray_hit &hit = hits[first + k];
+                if (!hit.hit) continue;
+                uint32_t *column = first_pixel + (first + k) * column_step;
+
+                const size_t itext = wall_kind(hit.cell);
+                // height of the wall: inversely proportional to the distance to the nearest obstacle
+                // think of the effect when you see things far away they appear "small" vs things closer to you.
+                // hit.dist is measured perpendicular to the camera plane, which takes care of the fish eye distortion
+                const size_t column_height = heights[k];
+                if (itext >= sc.walltext.count())
+                { // no texture for this kind of wall, it gets its map color
+                    const column_sampler s = make_column_sampler(nullptr, 1, column_height, img_h);
+                    if (transposed) std::fill_n(column + s.y0, s.y1 - s.y0, sc.colors[itext]);
+                    else draw_vspan(view, first + k, s.y0, s.y1, sc.colors[itext]);
+                    continue;
+                }
+                // far walls are only a few pixels tall, they read a smaller version of the texture
+                const size_t level = sc.walltext.level_for_height(column_height);
+                const size_t text_size = sc.walltext.size(level);
+                const size_t text_x = std::min(size_t(hit.text_x * text_size), text_size - 1);
+                fill_column(column, pixel_step,
+                            make_column_sampler(sc.walltext.column(itext, text_x, level), text_size, column_height, img_h));
+            }
+        }
+    });
+}
+
+void draw_sprites(const image_view view, const column_layout layout, const texture_atlas &spritetext,
+                  const std::vector<sprite_projection> &sprites, const float *depth, thread_pool &pool, const size_t tile_w)
+{
+    assert(tile_w > 0);
+    if (sprites.empty()) return;
+    const bool transposed = layout == column_layout::column_major;
+    const size_t ncolumns = transposed ? view.height() : view.width();
+    const size_t img_h = transposed ? view.width() : view.height();
+    uint32_t *first_pixel = view.row(0);
+    const size_t column_step = transposed ? view.pitch() : 1;
+    const size_t pixel_step = transposed ? 1 : view.pitch();
+
+    const size_t ntiles = (ncolumns + tile_w - 1) / tile_w;
+    pool.parallel_for(ntiles, [&](const size_t tile)
+    {
+        const size_t begin = tile * tile_w;
+        const size_t end = std::min(ncolumns, begin + tile_w);
+        for (const sprite_projection &p : sprites)
+        {
+            const size_t x0 = std::max(p.x0, begin), x1 = std::min(p.x1, end);
+            if (x0 >= x1 || p.texture >= spritetext.count()) continue;
+            const size_t level = spritetext.level_for_height(p.size);
+            const size_t text_size = spritetext.size(level);
+            // texture column of screen column x, 16.16 fixed point like the rows of make_column_sampler()
+            const uint32_t step = uint32_t((uint64_t(text_size) << 16) / p.size);
+            for (size_t x = x0; x < x1; x++)
+            {
+                if (depth[x] <= p.depth) continue; // behind the wall of this column
+                const size_t text_x = size_t((uint64_t(x - p.left) * step) >> 16);
+                const column_sampler s = make_column_sampler(spritetext.column(p.texture, text_x, level), text_size, p.size, img_h);
+                uint32_t *dst = first_pixel + x * column_step + s.y0 * pixel_step;
+                uint32_t v = s.v;
+                for (size_t y = s.y0; y < s.y1; y++)
+                {
+                    const uint32_t texel = s.texels[v >> 16];
+                    if (texel >= 0x80000000u) *dst = texel; // alpha in the top byte, see pack_color()
+                    dst += pixel_step;
+                    v += s.step;
+                }
+            }
+        }
+    });
+}
+
+void renderer::render_frame(framebuffer &fb, const scene &sc, const camera &cam, const float max_dist)
+{
+    const size_t img_w = fb.width();
+    const size_t img_h = fb.height();
+    const bool streaming = mClearMode == clear_mode::streaming ||
+                           (mClearMode == clear_mode::automatic && fb.pitch() * img_h * sizeof(uint32_t) > streaming_clear_bytes);
+    const image_view map_view = fb.view(0, 0, img_w / 2, img_h);
+    const image_view view_3d = fb.view(img_w / 2, 0, img_w - img_w / 2, img_h);
+    clear_image(map_view, pack_color(255, 255, 255), streaming);
+
+    const size_t rect_w = img_w / (sc.map.w * 2); // Left side of screen is map, right side is 3d projection
+    const size_t rect_h = img_h / sc.map.h;
+
+    assert(sc.colors.size() >= max_wall_kinds);
+    // maps too big for a pixel per cell get no minimap
+    const size_t minimap_h = rect_w > 0 && rect_h > 0 ? sc.map.h : 0;
+    for (size_t j = 0; j < minimap_h; j++)
+    { // draw the map
+        for (size_t i = 0; i < sc.map.w; i++)
+        {
+            const uint8_t cell = sc.map.at(i, j);
+            if (cell == empty_cell) continue; // skip empty spaces
+            size_t rect_x = i * rect_w;
+            size_t rect_y = j * rect_h;
+            draw_rectangle(map_view, rect_x, rect_y, rect_w, rect_h, sc.colors[wall_kind(cell)]);
+        }
+    }
+
+    // one ray direction per column, only rebuilt when the camera turns or the resolution changes
+    mRays.update(cam, view_3d.width());
+
+    // draw the 3d view on the right half of the screen: floor and ceiling first, walls over them
+    const bool textured = sc.floor_texture < sc.walltext.count() || sc.ceiling_texture < sc.walltext.count();
+    // once the walls are drawn: their depth, then the sprites that aren't entirely behind them, far to near
+    auto project_sprites = [&]()
+    {
+        mDepth.resize(mHits.size());
+        for (size_t i = 0; i < mHits.size(); i++) mDepth[i] = mHits[i].hit ? mHits[i].dist : INFINITY;
+        if (!sc.entities)
+        {
+            mSprites.project(sc.sprites, cam, view_3d.width(), img_h, mDepth.data(), max_dist);
+            return;
+        }
+        // a billboard is img_h * |plane| / img_w map cells wide on each side of its center, see sprite_list::project()
+        const float margin = img_h * std::sqrt(cam.plane_x * cam.plane_x + cam.plane_y * cam.plane_y) / view_3d.width();
+        mCandidateIds.clear();
+        sc.entities->query_view(cam, max_dist, margin, mCandidateIds);
+        mCandidates.clear();
+        for (const uint32_t id : mCandidateIds) mCandidates.push_back(sc.sprites[id]);
+        mSprites.project(mCandidates, cam, view_3d.width(), img_h, mDepth.data(), max_dist);
+    };
+    if (mLayout == column_layout::column_major)
+    {
+        mColumns.resize(view_3d.height(), view_3d.width());
+        if (textured) cast_floor_ceiling(mColumns.view(), column_layout::column_major, sc, cam, mPool);
+        else fill_sky_floor(mColumns.view(), column_layout::column_major, sc.ceiling_color, sc.floor_color, mPool, streaming);
+        render_walls(mColumns.view(), column_layout::column_major, sc, cam, mRays, max_dist, mPool, mHits);
+        project_sprites();
+        draw_sprites(mColumns.view(), column_layout::column_major, sc.spritetext, mSprites.sorted(), mDepth.data(), mPool);
+        // bands of transpose_block columns: each band only writes its own cache lines of the frame
+        const size_t nbands = (view_3d.width() + transpose_block - 1) / transpose_block;
+        mPool.parallel_for(nbands, [&](const size_t band)
+        {
+            const size_t x = band * transpose_block;
+            transpose(mColumns.view(0, x, view_3d.height(), transpose_block), view_3d.sub(x, 0, transpose_block, view_3d.height()));
+        });
+    }
+    else
+    {
+        if (textured) cast_floor_ceiling(view_3d, column_layout::row_major, sc, cam, mPool);
+        else fill_sky_floor(view_3d, column_layout::row_major, sc.ceiling_color, sc.floor_color, mPool, streaming);
+        render_walls(view_3d, column_layout::row_major, sc, cam, mRays, max_dist, mPool, mHits);
+        project_sprites();
+        draw_sprites(view_3d, column_layout::row_major, sc.spritetext, mSprites.sorted(), mDepth.data(), mPool);
+    }
+
+    // draw player view direction with fov: each ray up to the wall it hit, this draws the visibility cone
+    for (size_t i = 0; i < (minimap_h > 0 ? mRays.size() : 0); i++)
+    {
+        const float ray_len = mHits[i].hit ? mHits[i].dist : max_dist;
+        for (float t = 0; t < ray_len; t += 1.0f / rect_w)
+        {
+            // checked as floats: converting a negative one to size_t is undefined
+            const float pix_x = (cam.x + t * mRays.dir_x()[i]) * rect_w;
+            const float pix_y = (cam.y + t * mRays.dir_y()[i]) * rect_h;
+            if (!(pix_x >= 0.0f && pix_y >= 0.0f && pix_x < float(map_view.width()) && pix_y < float(map_view.height()))) break;
+            map_view.at(size_t(pix_x), size_t(pix_y)) = pack_color(160, 160, 160);
+        }
+    }
+
+    const size_t text_id = 4; // draw the ith texture on the screen
+    for(size_t i = 0; i < sc.walltext.size(); i++)
+    {
+        for(size_t j = 0; j < sc.walltext.size(); j++)
+        {
+            map_view.at(i, j) = sc.walltext.texel(text_id, i, j);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "camera.h"
+#include "entity_grid.h"
+#include "framebuffer.h"
+#include "raycast.h"
+#include "sprite.h"
+#include "texture.h"
+#include "thread_pool.h"
+
+constexpr size_t default_tile_w = 16; // columns per task handed to the thread pool
+constexpr size_t streaming_clear_bytes = 8 << 20; // frames bigger than this don't fit in the cache anyway, see clear_mode
+constexpr size_t no_texture = SIZE_MAX; // a floor or ceiling without a texture, see scene
+
+// What a frame is drawn from, apart from the camera
+struct scene
+{
+    map_view map;
+    traversal ray_mode = traversal::dda; // how render_walls() casts rays
+    tiled_view tiles;                      // map stored in tiles: if set, traversal::dda reads it, one ray at a time
+    const coarse_grid *coarse = nullptr;   // built from map, for traversal::coarse
+    const distance_field *field = nullptr; // built from map, for traversal::distance_field
+    std::vector<uint32_t> colors;   // color of each kind of wall, for the map: max_wall_kinds of them
+    texture_atlas walltext;       // textures of walls, wall kind i uses texture i if there is one, its color otherwise
+    uint32_t ceiling_color = 0xFFFFFFFF; // upper and lower half of the 3d view, behind the walls
+    uint32_t floor_color = 0xFFFFFFFF;
+    size_t ceiling_texture = no_texture; // textures of walltext for the same, instead of the colors
+    size_t floor_texture = no_texture;
+    std::vector<sprite> sprites; // billboards standing in the map, drawn over the walls they are in front of
+    texture_atlas spritetext;    // their textures, with an alpha channel: texels with alpha below 128 are see-through
+    const entity_grid *entities = nullptr; // sprites by grid bucket: if set, only the buckets the view crosses are projected
+};
+
+// Everything needed to fill the visible part of a textured wall column: texels are read from a single texture
+// column, v is a 16.16 fixed point position in it advancing by step per pixel
+struct column_sampler
+{
+    const uint32_t *texels = nullptr;
+    size_t y0 = 0; // first and one past the last row to draw, already clipped to the image
+    size_t y1 = 0;
+    uint32_t v = 0;
+    uint32_t step = 0;
+};
+
+// the only division of a column is here, along with the clipping
+column_sampler make_column_sampler(const uint32_t *texture_column, const size_t text_size, const size_t column_height, const size_t img_h);
+
+// no division and no bounds check per pixel, make_column_sampler() already took care of both
+// pitch is the distance between two pixels of the column: the image pitch, or 1 in a column-major image
+inline void fill_column(uint32_t *img_column, const size_t pitch, const column_sampler &s)
+{
+    uint32_t *dst = img_column + s.y0 * pitch;
+    uint32_t v = s.v;
+    for (size_t y = s.y0; y < s.y1; y++)
+    {
+        *dst = s.texels[v >> 16];
+        dst += pitch;
+        v += s.step;
+    }
+}
+
+// Everything needed to fill a span of a floor (or ceiling) row with a single texture: the texel coordinates u and v
+// are 16.16 fixed point, advancing by du and dv per pixel. The texture is size x size with size = 1 << shift, so
+// coordinates wrap around it for free with 32 bit arithmetic: the floor tiles the texture once per map cell
+struct span_sampler
+{
+    const uint32_t *texels = nullptr; // column-major, see texture_atlas
+    uint32_t shift = 0;
+    uint32_t u = 0;
+    uint32_t v = 0;
+    uint32_t du = 0;
+    uint32_t dv = 0;
+};
+
+// no division and no branch per pixel, so the loop vectorizes; draw_span() uses gathers where it can.
+// pitch is the distance between two pixels of the span: 1 in the 3d view, the image pitch in a column-major image
+inline void fill_span(uint32_t *img_span, const size_t pitch, const size_t n, const span_sampler &s)
+{
+    const uint32_t mask = (1u << s.shift) - 1;
+    uint32_t u = s.u, v = s.v;
+    for (size_t i = 0; i < n; i++)
+    {
+        img_span[i * pitch] = s.texels[((u >> 16) & mask) << s.shift | ((v >> 16) & mask)];
+        u += s.du;
+        v += s.dv;
+    }
+}
+
+// fill_span() of a contiguous span, with simd when the host has it
+void draw_span(uint32_t *img_span, const size_t n, const span_sampler &s);
+
+// How the columns of the 3d view are laid out in the image render_walls() draws into
+enum class column_layout
+{
+    row_major,    // the 3d view itself: each column is a pitch apart from one pixel to the next
+    column_major, // the 3d view transposed: column x is row x of the image, its pixels are contiguous
+};
+
+// Fills the upper half of the 3d view with the ceiling color and the lower half with the floor color, in bands of
+// rows spread over the pool. streaming: see fill_pixels()
+void fill_sky_floor(const image_view view, const column_layout layout, const uint32_t ceiling, const uint32_t floor,
+                    thread_pool &pool, const bool streaming);
+
+// Fills the upper half of the 3d view with the ceiling texture of sc and the lower half with its floor texture, as
+// seen from cam, or with the flat colors for a half without one. A row of the floor is all at the same distance from
+// the camera, so it is a straight line across the map: its texel coordinates are worked out once per row, then
+// stepped through linearly by draw_span(). Rows are spread over the pool in bands
+void cast_floor_ceiling(const image_view view, const column_layout layout, const scene &sc, const camera &cam, thread_pool &pool);
+
+// Casts one ray per column of the 3d view and draws the textured wall slices they hit, hits[i] receives the ray of the ith column.
+// A column only reads the scene and only writes to itself, so columns are grouped into tiles of tile_w
+// and the tiles are spread over the pool. Within a tile, rays are cast as sc.ray_mode says, in packets for traversal::dda.
+void render_walls(const image_view view, const column_layout layout, const scene &sc, const camera &cam, const ray_table &rays,
+                  const float max_dist, thread_pool &pool, std::vector<ray_hit> &hits, const size_t tile_w = default_tile_w);
+
+// Draws the billboards of sprites (from sprite_list::sorted(), far to near) over the walls, texels with alpha below
+// 128 are skipped. depth[x] is the distance of the wall of column x, ray_hit::dist or infinity when nothing was hit:
+// a column of a sprite only shows where the sprite is in front of it. Same tiles over the pool as render_walls(),
+// each tile goes through the sprites overlapping it in order
+void draw_sprites(const image_view view, const column_layout layout, const texture_atlas &spritetext,
+                  const std::vector<sprite_projection> &sprites, const float *depth, thread_pool &pool, const size_t tile_w = default_tile_w);
+
+// How the renderer clears the frame before drawing it
+enum class clear_mode
+{
+    cached,    // plain stores, best while the frame fits in the cache
+    streaming, // non-temporal stores (see fill_pixels()), best once it doesn't: the textures stay cached
+    automatic, // streaming for frames bigger than streaming_clear_bytes
+};
+
+// Draws whole frames: the map seen from above on the left half of the image, the 3d view on the right half.
+// Keeps whatever can be reused from one frame to the next: the threads, the ray table, the hits, the depth buffer.
+// With column_layout::column_major, the 3d view is drawn into a transposed buffer where every column is contiguous,
+// then transposed into the frame in cache sized blocks.
+class renderer
+{
+public:
+    explicit renderer(const size_t nthreads = 0, const column_layout layout = column_layout::row_major) : mPool(nthreads), mLayout(layout) {}
+
+    void render_frame(framebuffer &fb, const scene &sc, const camera &cam, const float max_dist);
+
+    const std::vector<ray_hit> &hits() const { return mHits; } // rays of the last frame, one per column of the 3d view
+    const sprite_list &sprites() const { return mSprites; }     // sprites of the last frame, after culling
+    thread_pool &pool() { return mPool; }
+    column_layout layout() const { return mLayout; }
+    void set_layout(const column_layout layout) { mLayout = layout; }
+    void set_clear_mode(const clear_mode mode) { mClearMode = mode; }
+
+private:
+    thread_pool mPool;
+    column_layout mLayout;
+    clear_mode mClearMode = clear_mode::automatic;
+    framebuffer mColumns; // the transposed 3d view, one row per column
+    ray_table mRays;
+    std::vector<ray_hit> mHits;
+    std::vector<float> mDepth; // distance of the wall of each column of the 3d view, for the sprites
+    std::vector<uint32_t> mCandidateIds; // sprites in the buckets of the view, when the scene has an entity_grid
+    std::vector<sprite> mCandidates;
+    sprite_list mSprites;
+};
+
+#endif // !RENDER_H
@@ -0,0 +1,101 @@
+#include "simd.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if TFR_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+#if TFR_X86
+    void cpuid(int regs[4], const int leaf, const int subleaf)
+    {
+#ifdef _MSC_VER
+        __cpuidex(regs, leaf, subleaf);
+#else
+        unsigned int a, b, c, d;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        regs[0] = int(a); regs[1] = int(b); regs[2] = int(c); regs[3] = int(d);
+#endif
+    }
+
+    // which register states the os saves on context switches
+    uint64_t xgetbv0()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        uint32_t lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (uint64_t(hi) << 32) | lo;
+#endif
+    }
+#endif
+
+    std::atomic<int> current_level{-1}; // -1: not detected yet
+}
+
+simd_level detect_simd_level()
+{
+#if TFR_X86
+    int regs[4];
+    cpuid(regs, 0, 0);
+    const int max_leaf = regs[0];
+
+    cpuid(regs, 1, 0);
+    if (!(regs[3] & (1 << 26))) return simd_level::scalar; // sse2
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+    if (!osxsave || !avx || max_leaf < 7) return simd_level::sse2;
+
+    const uint64_t xcr0 = xgetbv0();
+    if ((xcr0 & 0x6) != 0x6) return simd_level::sse2; // xmm and ymm state
+
+    // the kernels are built with /arch:AVX2 and /arch:AVX512 by msvc, which may emit anything those imply: fma along
+    // with avx2, and the cd, bw, dq and vl extensions along with avx512f
+    cpuid(regs, 7, 0);
+    const uint32_t ebx = uint32_t(regs[1]);
+    if (!(ebx & (1u << 5)) || !fma) return simd_level::sse2; // avx2
+    const uint32_t avx512 = (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31); // f, dq, cd, bw, vl
+    if ((ebx & avx512) != avx512 || (xcr0 & 0xe0) != 0xe0) return simd_level::avx2; // opmask and zmm state
+    return simd_level::avx512;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+simd_level get_simd_level()
+{
+    int level = current_level.load(std::memory_order_relaxed);
+    if (level < 0)
+    {
+        level = int(detect_simd_level());
+        current_level.store(level, std::memory_order_relaxed);
+    }
+    return simd_level(level);
+}
+
+void set_simd_level(const simd_level level)
+{
+    const simd_level best = detect_simd_level();
+    current_level.store(int(level) < int(best) ? int(level) : int(best), std::memory_order_relaxed);
+}
+
+const char *simd_level_name(const simd_level level)
+{
+    switch (level)
+    {
+        case simd_level::scalar: return "scalar";
+        case simd_level::sse2: return "sse2";
+        case simd_level::avx2: return "avx2";
+        case simd_level::avx512: return "avx512";
+    }
+    return "unknown";
+}
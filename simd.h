@@ -0,0 +1,28 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TFR_X86 1
+#else
+#define TFR_X86 0
+#endif
+
+// Instruction sets the packet kernels are compiled for, from the narrowest to the widest
+enum class simd_level
+{
+    scalar,
+    sse2,   // 4 lanes
+    avx2,   // 8 lanes
+    avx512, // 16 lanes
+};
+
+simd_level detect_simd_level(); // the widest level both the cpu and the os support
+
+// level used by the packet kernels, defaults to detect_simd_level().
+// set_simd_level() is there to compare levels against each other, it is clamped to what the host supports.
+simd_level get_simd_level();
+void set_simd_level(const simd_level level);
+
+const char *simd_level_name(const simd_level level);
+
+#endif // !SIMD_H
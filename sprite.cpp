@@ -0,0 +1,122 @@
+#include "sprite.h"
+#include "raycast.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void radix_sort(uint32_t *keys, uint32_t *values, const size_t n, uint32_t *tmp_keys, uint32_t *tmp_values)
+{
+    // the histograms of the four digits in a single pass over the keys
+    size_t counts[4][256] = {};
+    for (size_t i = 0; i < n; i++)
+    {
+        for (int d = 0; d < 4; d++) counts[d][(keys[i] >> (d * 8)) & 255]++;
+    }
+
+    uint32_t *src_keys = keys, *src_values = values, *dst_keys = tmp_keys, *dst_values = tmp_values;
+    for (int d = 0; d < 4; d++)
+    {
+        const size_t *count = counts[d];
+        if (n == 0 || count[(keys[0] >> (d * 8)) & 255] == n) continue; // every key has this digit, the pass changes nothing
+
+        size_t offsets[256];
+        size_t sum = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            offsets[b] = sum;
+            sum += count[b];
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            const size_t pos = offsets[(src_keys[i] >> (d * 8)) & 255]++;
+            dst_keys[pos] = src_keys[i];
+            dst_values[pos] = src_values[i];
+        }
+        std::swap(src_keys, dst_keys);
+        std::swap(src_values, dst_values);
+    }
+    if (src_keys != keys)
+    {
+        std::copy(src_keys, src_keys + n, keys);
+        std::copy(src_values, src_values + n, values);
+    }
+}
+
+void sprite_list::project(const std::vector<sprite> &sprites, const camera &cam, const size_t img_w, const size_t img_h,
+                          const float *depth, const float max_dist)
+{
+    mVisible.clear();
+    mFrustumCulled = 0;
+    mOccluded = 0;
+
+    const size_t ntiles = (img_w + depth_tile - 1) / depth_tile;
+    mTileDepth.assign(ntiles, INFINITY);
+    for (size_t t = 0; depth && t < ntiles; t++)
+    {
+        const size_t end = std::min(img_w, (t + 1) * depth_tile);
+        mTileDepth[t] = *std::max_element(depth + t * depth_tile, depth + end);
+    }
+
+    // a point at depth a along dir and b along plane is on the ray of camera_x = b / a, see ray_table: (a, b) is the
+    // point in the basis (dir, plane), the inverse of the 2x2 matrix of the camera
+    const float inv_det = 1.0f / (cam.plane_x * cam.dir_y - cam.dir_x * cam.plane_y);
+    // a sprite is size = img_h / a pixels wide, that is size / img_w in units of camera_x on each side of its
+    // center b / a: it shows if |b / a| - img_h / (a * img_w) < 1
+    const float half_w = float(img_h) / float(img_w);
+    for (const sprite &s : sprites)
+    {
+        const float sx = s.x - cam.x;
+        const float sy = s.y - cam.y;
+        const float b = inv_det * (cam.dir_y * sx - cam.dir_x * sy);
+        const float a = inv_det * (cam.plane_x * sy - cam.plane_y * sx);
+        // the near and far planes, then the sides of the view pushed out by the half width of the sprite
+        if (!(a >= sprite_near && a <= max_dist) || std::fabs(b) >= a + half_w)
+        {
+            mFrustumCulled++;
+            continue;
+        }
+
+        sprite_projection p;
+        p.depth = a;
+        p.texture = s.texture;
+        const float inv_a = 1.0f / a;
+        p.size = size_t(std::min(img_h * inv_a, max_column_height));
+        const float center = (1.0f + b * inv_a) * 0.5f * img_w;
+        p.left = (long long)std::floor(center - 0.5f * p.size);
+        p.x0 = size_t(std::max(p.left, 0LL));
+        p.x1 = size_t(std::max(std::min(p.left + (long long)p.size, (long long)img_w), 0LL)); // the frustum test rounds
+        if (p.x0 >= p.x1)
+        {
+            mFrustumCulled++;
+            continue;
+        }
+
+        // whole tiles of columns where every wall is in front of the sprite
+        while (p.x0 < p.x1 && mTileDepth[p.x0 / depth_tile] <= a) p.x0 = (p.x0 / depth_tile + 1) * depth_tile;
+        while (p.x0 < p.x1 && mTileDepth[(p.x1 - 1) / depth_tile] <= a) p.x1 = (p.x1 - 1) / depth_tile * depth_tile;
+        if (p.x0 >= p.x1)
+        {
+            mOccluded++;
+            continue;
+        }
+        mVisible.push_back(p);
+    }
+
+    // far to near: the bits of a positive float sort like the float, flipping them sorts backwards
+    const size_t n = mVisible.size();
+    mKeys.resize(n);
+    mIndices.resize(n);
+    mTmpKeys.resize(n);
+    mTmpIndices.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &mVisible[i].depth, sizeof(bits));
+        mKeys[i] = ~bits;
+        mIndices[i] = uint32_t(i);
+    }
+    radix_sort(mKeys.data(), mIndices.data(), n, mTmpKeys.data(), mTmpIndices.data());
+    mSorted.resize(n);
+    for (size_t i = 0; i < n; i++) mSorted[i] = mVisible[mIndices[i]];
+}
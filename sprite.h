@@ -0,0 +1,64 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "camera.h"
+
+// Something standing in the map that is not a wall: a monster, drawn as a billboard always facing the camera.
+// It is one cell wide and as tall as a wall, centered on (x, y)
+struct sprite
+{
+    float x = 0.0f; // position in map cells
+    float y = 0.0f;
+    size_t texture = 0; // in the sprite textures of the scene
+};
+
+// Where a sprite lands in the 3d view, once it made it through the culling
+struct sprite_projection
+{
+    float depth = 0.0f;    // distance to the camera plane, same units as ray_hit::dist
+    long long left = 0;    // column of the left edge of the billboard, may be off the screen
+    size_t size = 0;       // width and height in pixels
+    size_t x0 = 0;         // first and one past the last column that may show, clipped to the view and to the walls
+    size_t x1 = 0;
+    size_t texture = 0;
+};
+
+constexpr size_t depth_tile = 16; // columns per entry of the coarse depth buffer, see sprite_list
+constexpr float sprite_near = 0.05f; // sprites closer than this to the camera plane are not drawn
+
+// Sorts n keys in ascending order along with their values: least significant digit radix sort, 8 bits per pass,
+// the passes where every key has the same digit are skipped. tmp_keys and tmp_values hold n elements each.
+// The result lands back in keys and values
+void radix_sort(uint32_t *keys, uint32_t *values, const size_t n, uint32_t *tmp_keys, uint32_t *tmp_values);
+
+// The sprites of a frame, ready to draw from far to near. Keeps its buffers from one frame to the next.
+// project() runs on one thread and only does O(1) work per sprite before the sort:
+//  - frustum reject: sprites behind the camera, past max_dist or out of the sides of the view, before any division
+//  - occlusion reject: depth is the per-column depth buffer of the walls, its maximum over tiles of depth_tile
+//    columns trims the column range of a sprite down to the tiles where it may show, and drops it if none is left
+//  - the survivors are radix sorted on the bits of their depth, a positive float sorts like an unsigned int
+class sprite_list
+{
+public:
+    void project(const std::vector<sprite> &sprites, const camera &cam, const size_t img_w, const size_t img_h,
+                 const float *depth, const float max_dist);
+
+    // far to near, painter's order
+    const std::vector<sprite_projection> &sorted() const { return mSorted; }
+    size_t frustum_culled() const { return mFrustumCulled; }
+    size_t occluded() const { return mOccluded; }
+
+private:
+    std::vector<sprite_projection> mVisible;
+    std::vector<sprite_projection> mSorted;
+    std::vector<uint32_t> mKeys, mIndices, mTmpKeys, mTmpIndices;
+    std::vector<float> mTileDepth; // farthest wall of each tile of depth_tile columns
+    size_t mFrustumCulled = 0;
+    size_t mOccluded = 0;
+};
+
+#endif // !SPRITE_H
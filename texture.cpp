@@ -0,0 +1,67 @@
+#include "texture.h"
+#include "image.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    // average of four colors, channel by channel
+    uint32_t box_filter(const uint32_t c0, const uint32_t c1, const uint32_t c2, const uint32_t c3)
+    {
+        uint32_t res = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            const uint32_t sum = ((c0 >> shift) & 255) + ((c1 >> shift) & 255) + ((c2 >> shift) & 255) + ((c3 >> shift) & 255);
+            res |= ((sum + 2) / 4) << shift;
+        }
+        return res;
+    }
+}
+
+bool texture_atlas::load(const std::string filename)
+{
+    std::vector<uint32_t> base;
+    size_t text_size, text_count;
+    if (!load_texture(filename, base, text_size, text_count)) return false;
+    if (text_size == 0 || (text_size & (text_size - 1)) != 0)
+    {
+        std::cerr << "Error: the textures must have a power of two size to be mipmapped" << std::endl;
+        return false;
+    }
+
+    mSize = text_size;
+    mCount = text_count;
+    mLevelOffsets.clear();
+    mStride = 0;
+    for (size_t s = text_size; s > 0; s /= 2)
+    {
+        mLevelOffsets.push_back(mStride);
+        mStride += s * s;
+    }
+
+    mTexels.assign(mStride * mCount, 0);
+    for (size_t id = 0; id < mCount; id++)
+    {
+        std::copy(base.begin() + id * mSize * mSize, base.begin() + (id + 1) * mSize * mSize, mTexels.begin() + id * mStride);
+
+        // each level is a 2x2 box filter of the one above it
+        for (size_t level = 1; level < levels(); level++)
+        {
+            const uint32_t *src = texture(id, level - 1);
+            uint32_t *dst = mTexels.data() + id * mStride + mLevelOffsets[level];
+            const size_t src_size = size(level - 1);
+            const size_t dst_size = size(level);
+            for (size_t x = 0; x < dst_size; x++)
+            {
+                const uint32_t *col0 = src + (2 * x) * src_size;
+                const uint32_t *col1 = col0 + src_size;
+                for (size_t y = 0; y < dst_size; y++)
+                {
+                    dst[x * dst_size + y] = box_filter(col0[2 * y], col0[2 * y + 1], col1[2 * y], col1[2 * y + 1]);
+                }
+            }
+        }
+    }
+    return true;
+}
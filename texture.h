@@ -0,0 +1,45 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A set of square textures of the same size, with their mip chains. Each texture is a contiguous block of its own
+// holding the base level followed by every mip level down to 1x1, all of them stored column-major:
+// walls are drawn one vertical span at a time, so a span reads consecutive texels of a single column.
+class texture_atlas
+{
+public:
+    // N square textures packed horizontally in one 32 bit image, their size must be a power of two.
+    // Returns false (and says why) on failure
+    bool load(const std::string filename);
+
+    size_t size(const size_t level = 0) const { return mSize >> level; } // width and height of every texture
+    size_t count() const { return mCount; }
+    size_t levels() const { return mLevelOffsets.size(); }
+
+    // size(level) * size(level) texels, texel (x, y) is at [x * size(level) + y]
+    const uint32_t *texture(const size_t id, const size_t level = 0) const { return mTexels.data() + id * mStride + mLevelOffsets[level]; }
+    const uint32_t *column(const size_t id, const size_t x, const size_t level = 0) const { return texture(id, level) + x * size(level); }
+    uint32_t texel(const size_t id, const size_t x, const size_t y, const size_t level = 0) const { return column(id, x, level)[y]; }
+
+    // the smallest level still having at least one texel per pixel of a column_height pixels tall wall.
+    // Far walls sample small levels: less memory traffic and no shimmering
+    size_t level_for_height(const size_t column_height) const
+    {
+        size_t level = 0;
+        while (level + 1 < levels() && size(level + 1) >= column_height) level++;
+        return level;
+    }
+
+private:
+    std::vector<uint32_t> mTexels;
+    std::vector<size_t> mLevelOffsets; // where each level starts within the block of a texture
+    size_t mStride = 0;                // texels per texture, all levels included
+    size_t mSize = 0;
+    size_t mCount = 0;
+};
+
+#endif // !TEXTURE_H
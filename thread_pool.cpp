@@ -0,0 +1,119 @@
+#include "thread_pool.h"
+
+thread_pool::thread_pool(const size_t nthreads)
+{
+    size_t n = nthreads ? nthreads : std::thread::hardware_concurrency();
+    if (n == 0) n = 1;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        mQueues.emplace_back(new task_queue);
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        mThreads.emplace_back(&thread_pool::worker_loop, this, i);
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWakeCv.notify_all();
+    for (std::thread &t : mThreads)
+    {
+        t.join();
+    }
+}
+
+void thread_pool::parallel_for(const size_t count, const std::function<void(size_t)> &func)
+{
+    if (count == 0) return;
+    if (mThreads.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    mRemaining = count;
+    const size_t nqueues = mQueues.size();
+    for (size_t q = 0; q < nqueues; q++)
+    {
+        std::lock_guard<std::mutex> lock(mQueues[q]->mutex);
+        for (size_t i = q * count / nqueues; i < (q + 1) * count / nqueues; i++)
+        {
+            mQueues[q]->tasks.push_back({&func, i});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mGeneration++;
+    }
+    mWakeCv.notify_all();
+
+    run_tasks(0);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCv.wait(lock, [this]() { return mRemaining == 0; });
+}
+
+void thread_pool::worker_loop(const size_t id)
+{
+    size_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWakeCv.wait(lock, [&]() { return mStop || mGeneration != seen; });
+            if (mStop) return;
+            seen = mGeneration;
+        }
+        run_tasks(id);
+    }
+}
+
+void thread_pool::run_tasks(const size_t id)
+{
+    task t;
+    while (pop_task(id, t))
+    {
+        (*t.func)(t.index);
+        if (--mRemaining == 0)
+        {
+            std::lock_guard<std::mutex> lock(mMutex); // so the notification can't slip in before parallel_for() waits
+            mDoneCv.notify_all();
+        }
+    }
+}
+
+bool thread_pool::pop_task(const size_t id, task &t)
+{
+    {
+        task_queue &own = *mQueues[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            t = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // our queue is empty, steal from the back of someone else's
+    for (size_t k = 1; k < mQueues.size(); k++)
+    {
+        task_queue &victim = *mQueues[(id + k) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            t = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
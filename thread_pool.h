@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running parallel_for() jobs with work stealing.
+// Every thread, the caller included, owns a queue of task indices. A job is split into contiguous blocks,
+// one per queue. Threads pop from the front of their own queue and, once it is empty, steal from the back of
+// the others, so threads that got cheap tasks end up helping with the expensive ones.
+class thread_pool
+{
+public:
+    explicit thread_pool(const size_t nthreads = 0); // 0 picks std::thread::hardware_concurrency()
+    ~thread_pool();
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    size_t size() const { return mQueues.size(); } // number of threads working on a job, the caller included
+
+    // calls func(i) once for every i in [0, count) and returns once they are all done.
+    // The calling thread works on the job too. Not reentrant: func must not call parallel_for().
+    void parallel_for(const size_t count, const std::function<void(size_t)> &func);
+
+private:
+    struct task
+    {
+        const std::function<void(size_t)> *func;
+        size_t index;
+    };
+
+    struct task_queue
+    {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    void worker_loop(const size_t id);
+    void run_tasks(const size_t id);
+    bool pop_task(const size_t id, task &t);
+
+    std::vector<std::unique_ptr<task_queue>> mQueues; // mQueues[0] belongs to the thread calling parallel_for()
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mWakeCv; // workers wait here for a new job
+    std::condition_variable mDoneCv; // parallel_for() waits here for the job to finish
+    size_t mGeneration = 0;          // bumped for every job
+    bool mStop = false;
+    std::atomic<size_t> mRemaining{0};
+};
+
+#endif // !THREAD_POOL_H
@@ -0,0 +1,22 @@
+#include "tiled_map.h"
+
+void tiled_map::build(const map_view &map)
+{
+    mW = map.w;
+    mH = map.h;
+    mTilesW = (map.w + map_tile - 1) / map_tile;
+    const size_t tiles_h = (map.h + map_tile - 1) / map_tile;
+    mCells.assign(mTilesW * tiles_h * map_tile * map_tile, empty_cell);
+    mBits.assign(mTilesW * tiles_h, 0);
+
+    const tiled_view tiles = view();
+    for (size_t y = 0; y < map.h; y++)
+    {
+        for (size_t x = 0; x < map.w; x++)
+        {
+            const uint8_t cell = map.at(x, y);
+            mCells[tiles.tile(x, y) * map_tile * map_tile + tiles.bit(x, y)] = cell;
+            if (cell != empty_cell) mBits[tiles.tile(x, y)] |= uint64_t(1) << tiles.bit(x, y);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef TILED_MAP_H
+#define TILED_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer.h"
+#include "map.h"
+
+constexpr size_t map_tile = 8; // a tile is 8x8 cells: a cache line of cells, a single word of occupancy bits
+static_assert(map_tile * map_tile == 64, "the occupancy bits of a tile are a 64 bit word");
+
+// What the ray caster takes instead of a map_view to read a map stored in tiles: the tiles are row-major, and so are
+// the cells inside a tile. A ray stays in the same tile for several steps whichever way it goes, where in a
+// row-major map a mostly vertical ray reads a new cache line at every step once rows are longer than a line.
+// Same accessors as map_view (w, h, at(), wall()), the traversals are written once for both. Cheap to copy
+struct tiled_view
+{
+    const uint8_t *cells = nullptr;  // map_tile * map_tile cells per tile, tile after tile
+    const uint64_t *bits = nullptr;  // one word of occupancy bits per tile, bit (x % 8) + (y % 8) * 8
+    size_t w = 0;
+    size_t h = 0;
+    size_t tiles_w = 0; // tiles in a row of tiles
+
+    size_t tile(const size_t x, const size_t y) const { return x / map_tile + y / map_tile * tiles_w; }
+    size_t bit(const size_t x, const size_t y) const { return x % map_tile + y % map_tile * map_tile; }
+
+    uint8_t at(const size_t x, const size_t y) const { return cells[tile(x, y) * map_tile * map_tile + bit(x, y)]; }
+    bool wall(const size_t x, const size_t y) const { return (bits[tile(x, y)] >> bit(x, y)) & 1; }
+};
+
+// A copy of a map in tiles, see tiled_view. Built from a map_view and not kept in sync with it: rebuild it when the
+// map changes. Cells of the tiles that stick out of the map are empty
+class tiled_map
+{
+public:
+    tiled_map() = default;
+    explicit tiled_map(const map_view &map) { build(map); }
+
+    void build(const map_view &map);
+
+    tiled_view view() const { return tiled_view{mCells.data(), mBits.data(), mW, mH, mTilesW}; }
+
+private:
+    std::vector<uint8_t, aligned_allocator<uint8_t>> mCells; // tiles start on a cache line
+    std::vector<uint64_t> mBits;
+    size_t mW = 0;
+    size_t mH = 0;
+    size_t mTilesW = 0;
+};
+
+#endif // !TILED_MAP_H